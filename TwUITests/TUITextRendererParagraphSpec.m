@@ -0,0 +1,75 @@
+//
+//  TUITextRendererParagraphSpec.m
+//  TwUITests
+//
+
+#import <TwUI/TUIKit.h>
+#import <TwUI/TUITextRenderer+Private.h>
+
+// what splitting the whole string again would give
+static NSArray *TUIParagraphRangesOfString(NSString *string)
+{
+	NSMutableArray *ranges = [NSMutableArray array];
+	NSUInteger location = 0;
+	while(location < [string length]) {
+		NSRange range = [string paragraphRangeForRange:NSMakeRange(location, 0)];
+		[ranges addObject:[NSValue valueWithRange:range]];
+		location = NSMaxRange(range);
+	}
+	return ranges;
+}
+
+SpecBegin(TUITextRendererParagraphs)
+
+	__block TUITextEditor *editor = nil;
+
+	beforeEach(^{
+		editor = [[TUITextEditor alloc] init];
+		editor.frame = CGRectMake(0, 0, 300, 1000);
+		editor.text = @"one\ntwo\nthree";
+		expect([editor _usesParagraphLayouts]).to.beTruthy();
+	});
+
+	it(@"should split the text into paragraphs", ^{
+		expect([editor _paragraphRanges]).to.equal(TUIParagraphRangesOfString(editor.text));
+		expect([editor _paragraphRanges]).to.haveCountOf(3);
+	});
+
+	it(@"should shift the paragraphs after an insertion", ^{
+		[editor insertText:@"xyz" replacementRange:NSMakeRange(5, 0)];
+		expect(editor.text).to.equal(@"one\ntxyzwo\nthree");
+		expect([editor _paragraphRanges]).to.equal(TUIParagraphRangesOfString(editor.text));
+	});
+
+	it(@"should split a paragraph when a newline is inserted", ^{
+		[editor insertText:@"\n" replacementRange:NSMakeRange(1, 0)];
+		expect([editor _paragraphRanges]).to.equal(TUIParagraphRangesOfString(editor.text));
+		expect([editor _paragraphRanges]).to.haveCountOf(4);
+	});
+
+	it(@"should join paragraphs when a newline is deleted", ^{
+		[editor deleteCharactersInRange:NSMakeRange(3, 1)];
+		expect(editor.text).to.equal(@"onetwo\nthree");
+		expect([editor _paragraphRanges]).to.equal(TUIParagraphRangesOfString(editor.text));
+		expect([editor _paragraphRanges]).to.haveCountOf(2);
+	});
+
+	it(@"should handle a replacement spanning paragraphs", ^{
+		[editor insertText:@"a\nb" replacementRange:NSMakeRange(2, 8)];
+		expect(editor.text).to.equal(@"ona\nbree");
+		expect([editor _paragraphRanges]).to.equal(TUIParagraphRangesOfString(editor.text));
+	});
+
+	it(@"should handle edits at the very end", ^{
+		[editor insertText:@"\n" replacementRange:NSMakeRange(13, 0)];
+		expect([editor _paragraphRanges]).to.equal(TUIParagraphRangesOfString(editor.text));
+		[editor insertText:@"four" replacementRange:NSMakeRange(14, 0)];
+		expect([editor _paragraphRanges]).to.equal(TUIParagraphRangesOfString(editor.text));
+	});
+
+	it(@"should have no paragraphs once everything is deleted", ^{
+		[editor deleteCharactersInRange:NSMakeRange(0, 13)];
+		expect([editor _paragraphRanges]).to.haveCountOf(0);
+	});
+
+SpecEnd
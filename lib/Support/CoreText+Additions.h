@@ -25,6 +25,32 @@ typedef enum {
 	AB_CTLineRectAggregationTypeBlock,
 } AB_CTLineRectAggregationType;
 
+// Metrics of one line of a frame. Origins are relative to the frame's path, as from CTFrameGetLineOrigins().
+typedef struct {
+	CTLineRef line;
+	CFRange stringRange;
+	CGPoint origin;
+	CGFloat ascent;
+	CGFloat descent;
+	CGFloat leading;
+	CGFloat width;
+} AB_CTLineMetrics;
+
+// A frame's lines and their metrics, gathered once so that finding a line by position or by string index is a binary search. Keep one around for as long as its frame when making many queries.
+typedef struct {
+	CTFrameRef frame;
+	CGRect bounds; // of the frame's path
+	CFIndex lineCount;
+	AB_CTLineMetrics *lines;
+} AB_CTLineTable;
+
+extern AB_CTLineTable *AB_CTLineTableCreate(CTFrameRef frame);
+extern void AB_CTLineTableRelease(AB_CTLineTable *table);
+extern CFIndex AB_CTLineTableGetLineIndexForStringIndex(AB_CTLineTable *table, CFIndex index); // the last line for indexes past the end, -1 if there are no lines
+extern CFIndex AB_CTLineTableGetStringIndexForPosition(AB_CTLineTable *table, CGPoint p);
+extern void AB_CTLineTableGetLinePositionOfIndex(AB_CTLineTable *table, CFIndex index, CFIndex *lineIndex, float *xPosition);
+extern void AB_CTLineTableGetRectsForRange(AB_CTLineTable *table, CFRange range, AB_CTLineRectAggregationType aggregationType, CGRect rects[], CFIndex *rectCount);
+
 extern CGSize AB_CTLineGetSize(CTLineRef line);
 extern CGSize AB_CTFrameGetSize(CTFrameRef frame);
 extern CGFloat AB_CTFrameGetHeight(CTFrameRef frame);
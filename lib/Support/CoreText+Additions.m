@@ -88,56 +88,160 @@ CGFloat AB_CTFrameGetHeight(CTFrameRef f)
 
 CFIndex AB_CTFrameGetStringIndexForPosition(CTFrameRef frame, CGPoint p)
 {
-	NSArray *lines = (__bridge NSArray *)CTFrameGetLines(frame);
+	AB_CTLineTable *table = AB_CTLineTableCreate(frame);
+	CFIndex index = AB_CTLineTableGetStringIndexForPosition(table, p);
+	AB_CTLineTableRelease(table);
+	return index;
+}
+
+static inline BOOL RangeContainsIndex(CFRange range, CFIndex index)
+{
+	BOOL a = (index >= range.location);
+	BOOL b = (index <= (range.location + range.length));
+	return (a && b);
+}
+
+AB_CTLineTable *AB_CTLineTableCreate(CTFrameRef frame)
+{
+	AB_CTLineTable *table = calloc(1, sizeof(AB_CTLineTable));
+	table->frame = CFRetain(frame);
+	if(!CGPathIsRect(CTFrameGetPath(frame), &table->bounds))
+		table->bounds = CGPathGetBoundingBox(CTFrameGetPath(frame));
 	
+	NSArray *lines = (__bridge NSArray *)CTFrameGetLines(frame);
 	CFIndex linesCount = [lines count];
-	CGPoint *lineOrigins = (CGPoint *) malloc(sizeof(CGPoint) * linesCount);
-	CTFrameGetLineOrigins(frame, CFRangeMake(0, linesCount), lineOrigins);
-	
-	CTLineRef line = NULL;
-	CGPoint lineOrigin = CGPointZero;
+	table->lineCount = linesCount;
+	table->lines = calloc(MAX(linesCount, 1), sizeof(AB_CTLineMetrics));
 	
+	CGPoint *lineOrigins = (CGPoint *) malloc(sizeof(CGPoint) * MAX(linesCount, 1));
+	CTFrameGetLineOrigins(frame, CFRangeMake(0, linesCount), lineOrigins);
 	for(CFIndex i = 0; i < linesCount; ++i) {
-		line = (__bridge CTLineRef)[lines objectAtIndex:i];
-		lineOrigin = lineOrigins[i];
-		CGFloat descent, ascent;
-		CTLineGetTypographicBounds(line, &ascent, &descent, NULL);
-		if(p.y > (floor(lineOrigin.y) - floor(descent))) { // above bottom of line
-			if(i == 0 && (p.y > (ceil(lineOrigin.y) + ceil(ascent)))) { // above top of first line
-				free(lineOrigins);
-				return 0;
-			} else {
-				goto found;
-			}
-		}
+		AB_CTLineMetrics *l = &table->lines[i];
+		l->line = (__bridge CTLineRef)[lines objectAtIndex:i];
+		l->stringRange = CTLineGetStringRange(l->line);
+		l->origin = lineOrigins[i];
+		l->width = CTLineGetTypographicBounds(l->line, &l->ascent, &l->descent, &l->leading);
 	}
-	
 	free(lineOrigins);
 	
-	// didn't find a line, must be beneath the last line
-	return CTFrameGetStringRange(frame).length; // last character index
+	return table;
+}
 
-found:
+void AB_CTLineTableRelease(AB_CTLineTable *table)
+{
+	if(!table)
+		return;
+	CFRelease(table->frame);
+	free(table->lines);
+	free(table);
+}
 
-	p.x -= lineOrigin.x;
-	p.y -= lineOrigin.y;
+CFIndex AB_CTLineTableGetLineIndexForStringIndex(AB_CTLineTable *table, CFIndex index)
+{
+	if(table->lineCount == 0)
+		return -1;
 	
-	if(line) {
-		CFIndex i = CTLineGetStringIndexForPosition(line, p);
-		free(lineOrigins);
-		return i;
+	// first line ending after index
+	CFIndex lo = 0, hi = table->lineCount - 1;
+	while(lo < hi) {
+		CFIndex mid = (lo + hi) / 2;
+		CFRange r = table->lines[mid].stringRange;
+		if(index < r.location + r.length)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+CFIndex AB_CTLineTableGetStringIndexForPosition(AB_CTLineTable *table, CGPoint p)
+{
+	// first line whose bottom is below p, lines go down the frame
+	CFIndex lo = 0, hi = table->lineCount;
+	while(lo < hi) {
+		CFIndex mid = (lo + hi) / 2;
+		AB_CTLineMetrics *l = &table->lines[mid];
+		if(p.y > (floor(l->origin.y) - floor(l->descent)))
+			hi = mid;
+		else
+			lo = mid + 1;
 	}
 	
-	free(lineOrigins);
+	if(lo == table->lineCount) {
+		// didn't find a line, must be beneath the last line
+		return CTFrameGetStringRange(table->frame).length; // last character index
+	}
 	
-	return 0;
+	AB_CTLineMetrics *l = &table->lines[lo];
+	if(lo == 0 && (p.y > (ceil(l->origin.y) + ceil(l->ascent)))) // above top of first line
+		return 0;
+	
+	p.x -= l->origin.x;
+	p.y -= l->origin.y;
+	return CTLineGetStringIndexForPosition(l->line, p);
 }
 
-static inline BOOL RangeContainsIndex(CFRange range, CFIndex index)
+void AB_CTLineTableGetLinePositionOfIndex(AB_CTLineTable *table, CFIndex index, CFIndex *lineIndex, float *xPosition)
 {
-	BOOL a = (index >= range.location);
-	BOOL b = (index <= (range.location + range.length));
-	return (a && b);
+	CFIndex i = AB_CTLineTableGetLineIndexForStringIndex(table, index);
+	*lineIndex = i;
+	*xPosition = (i >= 0) ? CTLineGetOffsetForStringIndex(table->lines[i].line, index, NULL) : 0;
+}
+
+void AB_CTLineTableGetRectsForRange(AB_CTLineTable *table, CFRange range, AB_CTLineRectAggregationType aggregationType, CGRect rects[], CFIndex *rectCount)
+{
+	CFIndex maxRects = *rectCount;
+	CFIndex rectIndex = 0;
+	
+	CFIndex startIndex = range.location;
+	CFIndex endIndex = startIndex + range.length;
+	CGRect bounds = table->bounds;
+	CFIndex linesCount = table->lineCount;
+	
+	// lines before the first one reaching startIndex can't be in the range
+	CFIndex lo = 0, hi = linesCount;
+	while(lo < hi) {
+		CFIndex mid = (lo + hi) / 2;
+		CFRange r = table->lines[mid].stringRange;
+		if(r.location + r.length >= startIndex)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	
+	for(CFIndex i = lo; i < linesCount && rectIndex < maxRects; ++i) {
+		AB_CTLineMetrics *l = &table->lines[i];
+		CFIndex lineStartIndex = l->stringRange.location;
+		CFIndex lineEndIndex = lineStartIndex + l->stringRange.length;
+		if(lineStartIndex > endIndex)
+			break;
+		
+		BOOL containsStartIndex = RangeContainsIndex(l->stringRange, startIndex);
+		BOOL containsEndIndex = RangeContainsIndex(l->stringRange, endIndex);
+		if(!containsStartIndex && !containsEndIndex && !RangeContainsIndex(range, lineStartIndex))
+			continue;
+		if(containsStartIndex && !containsEndIndex && startIndex == lineEndIndex)
+			continue;
+		
+		// If we have more than 1 line, we want to find the real height of the line by measuring the distance between the current line and previous line. If it's only 1 line, then we'll guess the line's height.
+		BOOL useRealHeight = i < linesCount - 1;
+		CGFloat neighborLineY = i > 0 ? table->lines[i - 1].origin.y : (useRealHeight ? table->lines[i + 1].origin.y : 0.0f);
+		CGFloat lineHeight = ceil(useRealHeight ? floor(fabs(neighborLineY - l->origin.y)) : l->ascent + l->descent + l->leading);
+		CGFloat line_y = round(useRealHeight ? l->origin.y + bounds.origin.y - lineHeight/2 + l->descent : l->origin.y - l->descent + bounds.origin.y);
+		
+		// lines the range starts before begin at their left edge, lines it ends after run to the right edge
+		CGFloat startOffset = containsStartIndex ? CTLineGetOffsetForStringIndex(l->line, startIndex, NULL) : 0.0f;
+		CGFloat width = bounds.size.width - startOffset;
+		if(containsEndIndex && aggregationType != AB_CTLineRectAggregationTypeBlock)
+			width = CTLineGetOffsetForStringIndex(l->line, endIndex, NULL) - startOffset;
+		
+		rects[rectIndex++] = CGRectMake(bounds.origin.x + l->origin.x + startOffset, line_y, width, lineHeight);
+		
+		if(containsStartIndex && containsEndIndex)
+			break;
+	}
+	
+	*rectCount = rectIndex;
 }
 
 void AB_CTFrameGetIndexForPositionInLine(NSString *string, CTFrameRef frame, CFIndex lineIndex, float xPosition, CFIndex *index)
@@ -155,27 +259,9 @@ void AB_CTFrameGetIndexForPositionInLine(NSString *string, CTFrameRef frame, CFI
 
 void AB_CTFrameGetLinePositionOfIndex(NSString *string, CTFrameRef frame, CFIndex index, CFIndex *lineIndex, float *xPosition)
 {
-	NSArray *lines = (__bridge NSArray *)CTFrameGetLines(frame);
-	CFIndex linesCount = [lines count];
-	CFIndex charCount = 0;
-	CFIndex count = 0;
-	
-	for(CFIndex i = 0; i < linesCount; ++i) {
-		CTLineRef line = (__bridge CTLineRef)[lines objectAtIndex:i];
-		count = CTLineGetGlyphCount(line);
-		
-		if((index >= charCount && index < charCount + count) || i == linesCount - 1) {
-			CGFloat offset = CTLineGetOffsetForStringIndex(line, index, NULL);
-			*lineIndex = i;
-			*xPosition = offset;
-			return;
-		}
-		
-		charCount += count;
-	}
-	
-	*lineIndex = -1;
-	*xPosition = 0;
+	AB_CTLineTable *table = AB_CTLineTableCreate(frame);
+	AB_CTLineTableGetLinePositionOfIndex(table, index, lineIndex, xPosition);
+	AB_CTLineTableRelease(table);
 }
 
 void AB_CTFrameGetRectsForRange(CTFrameRef frame, CFRange range, CGRect rects[], CFIndex *rectCount)
@@ -185,16 +271,9 @@ void AB_CTFrameGetRectsForRange(CTFrameRef frame, CFRange range, CGRect rects[],
 
 void AB_CTFrameGetRectsForRangeWithAggregationType(CTFrameRef frame, CFRange range, AB_CTLineRectAggregationType aggregationType, CGRect rects[], CFIndex *rectCount)
 {
-	CGRect bounds;
-	CGPathIsRect(CTFrameGetPath(frame), &bounds);
-	
-	NSArray *lines = (__bridge NSArray *)CTFrameGetLines(frame);
-	CFIndex linesCount = [lines count];
-	CGPoint *lineOrigins = (CGPoint *) malloc(sizeof(CGPoint) * linesCount);
-	CTFrameGetLineOrigins(frame, CFRangeMake(0, linesCount), lineOrigins);
-	
-	AB_CTLinesGetRectsForRangeWithAggregationType(lines, lineOrigins, bounds, range, aggregationType, rects, rectCount);
-	free(lineOrigins);
+	AB_CTLineTable *table = AB_CTLineTableCreate(frame);
+	AB_CTLineTableGetRectsForRange(table, range, aggregationType, rects, rectCount);
+	AB_CTLineTableRelease(table);
 }
 
 void AB_CTLinesGetRectsForRangeWithAggregationType(NSArray *lines, CGPoint *lineOrigins, CGRect bounds, CFRange range, AB_CTLineRectAggregationType aggregationType, CGRect rects[], CFIndex *rectCount)
@@ -36,6 +36,17 @@ extern CGContextRef TUICreateGraphicsContext(CGSize size);
 extern CGContextRef TUICreateGraphicsContextWithOptions(CGSize size, BOOL opaque);
 extern CGImageRef TUICreateCGImageFromBitmapContext(CGContextRef ctx);
 
+// bitmap contexts drawing into a buffer you own, images of them share the buffer instead of copying it
+extern CGContextRef TUICreateGraphicsContextWithData(CGSize size, BOOL opaque, CFMutableDataRef *data);
+extern CGImageRef TUICreateCGImageWithBitmapContextData(CGContextRef ctx, CFDataRef data);
+
+/**
+ Buffers for TUICreateGraphicsContextWithData() come from a process-wide pool. Hand a buffer back once you're done with its context so it can be reused by the next context of a similar size (you still release your own reference). A buffer that images made with TUICreateCGImageWithBitmapContextData() still share joins the pool once the last of them is released. Idle buffers beyond the byte limit (64MB by default) are freed, least recently used first.
+ */
+extern void TUIRecycleGraphicsContextData(CFMutableDataRef data);
+extern BOOL TUIGraphicsContextDataIsInUse(CFDataRef data); // whether images made with TUICreateCGImageWithBitmapContextData() still share it
+extern void TUISetGraphicsContextDataPoolByteLimit(size_t limit);
+
 extern CGPathRef TUICGPathCreateRoundedRect(CGRect rect, CGFloat radius);
 extern CGPathRef TUICGPathCreateRoundedRectWithCorners(CGRect rect, CGFloat radius, TUICGRoundedRectCorner corners);
 extern void CGContextAddRoundRect(CGContextRef context, CGRect rect, CGFloat radius);
@@ -54,6 +65,27 @@ extern CGContextRef TUIGraphicsGetCurrentContext(void);
 extern void TUIGraphicsPushContext(CGContextRef context);
 extern void TUIGraphicsPopContext(void);
 
+/**
+ Everything a drawing pass needs to know about where it's drawing. Views set one up for each draw and hand it to their drawInContext block; drawRect: and other code below a draw can find it with TUIGraphicsGetCurrentDrawContext(). Each thread has its own current draw context, so views drawing on several threads at once don't share any state.
+ */
+typedef struct TUIDrawContext {
+	CGContextRef context;
+	CGFloat scale; // pixels per point
+	CGRect dirtyRect; // in the coordinates of the view being drawn
+	
+	// quality hints, already applied to context when drawing starts
+	BOOL shouldAntialias;
+	BOOL shouldSmoothFonts;
+	CGInterpolationQuality interpolationQuality;
+	
+	struct TUIDrawContext *previous;
+} TUIDrawContext;
+
+// also pushes drawContext->context for AppKit drawing, drawContext must stay alive until it's popped
+extern void TUIGraphicsPushDrawContext(TUIDrawContext *drawContext);
+extern void TUIGraphicsPopDrawContext(void);
+extern TUIDrawContext *TUIGraphicsGetCurrentDrawContext(void); // NULL outside of a draw
+
 extern NSImage *TUIGraphicsContextGetImage(CGContextRef ctx);
 
 extern void TUIGraphicsBeginImageContext(CGSize size);
@@ -16,6 +16,15 @@
 
 #import "TUICGAdditions.h"
 #import "TUIView.h"
+#import <libkern/OSAtomic.h>
+#import <pthread.h>
+
+static OSSpinLock TUIGraphicsContextDataPoolLock = OS_SPINLOCK_INIT;
+static CFMutableArrayRef TUIGraphicsContextDataPool = NULL; // idle buffers, least recently recycled first
+static size_t TUIGraphicsContextDataPoolBytes = 0;
+static size_t TUIGraphicsContextDataPoolByteLimit = 64 * 1024 * 1024;
+static CFMutableDictionaryRef TUIGraphicsContextDataImageCounts = NULL; // buffer -> how many images share it, while any do
+static CFMutableSetRef TUIGraphicsContextDataWaiting = NULL; // recycled buffers that go in the pool once their images are gone
 
 CGContextRef TUICreateOpaqueGraphicsContext(CGSize size)
 {
@@ -58,6 +67,176 @@ CGImageRef TUICreateCGImageFromBitmapContext(CGContextRef ctx) // autoreleased
 	return CGBitmapContextCreateImage(ctx);
 }
 
+// four size classes per power of two, so at most a quarter of a buffer goes unused
+static size_t TUIGraphicsContextDataSizeClass(size_t length)
+{
+	size_t p = 4096;
+	if(length <= p)
+		return p;
+	while(p * 2 < length)
+		p *= 2;
+	size_t step = p / 4;
+	return ((length + step - 1) / step) * step;
+}
+
+// lock must be held
+static void TUITrimGraphicsContextDataPool(void)
+{
+	while(TUIGraphicsContextDataPoolBytes > TUIGraphicsContextDataPoolByteLimit && CFArrayGetCount(TUIGraphicsContextDataPool) > 0) {
+		TUIGraphicsContextDataPoolBytes -= CFDataGetLength(CFArrayGetValueAtIndex(TUIGraphicsContextDataPool, 0));
+		CFArrayRemoveValueAtIndex(TUIGraphicsContextDataPool, 0);
+	}
+}
+
+// lock must be held
+static void TUIAddGraphicsContextDataToPool(CFMutableDataRef data)
+{
+	if(!TUIGraphicsContextDataPool)
+		TUIGraphicsContextDataPool = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	CFArrayAppendValue(TUIGraphicsContextDataPool, data);
+	TUIGraphicsContextDataPoolBytes += CFDataGetLength(data);
+	TUITrimGraphicsContextDataPool();
+}
+
+// lock must be held
+static CFIndex TUIGraphicsContextDataGetImageCount(CFDataRef data)
+{
+	if(!TUIGraphicsContextDataImageCounts)
+		return 0;
+	return (CFIndex)CFDictionaryGetValue(TUIGraphicsContextDataImageCounts, data);
+}
+
+BOOL TUIGraphicsContextDataIsInUse(CFDataRef data)
+{
+	OSSpinLockLock(&TUIGraphicsContextDataPoolLock);
+	BOOL inUse = TUIGraphicsContextDataGetImageCount(data) > 0;
+	OSSpinLockUnlock(&TUIGraphicsContextDataPoolLock);
+	return inUse;
+}
+
+static CFMutableDataRef TUICreateGraphicsContextDataFromPool(size_t length, BOOL *reused)
+{
+	size_t sizeClass = TUIGraphicsContextDataSizeClass(length);
+	CFMutableDataRef data = NULL;
+	
+	OSSpinLockLock(&TUIGraphicsContextDataPoolLock);
+	if(TUIGraphicsContextDataPool) {
+		for(CFIndex i = CFArrayGetCount(TUIGraphicsContextDataPool) - 1; i >= 0; --i) {
+			CFMutableDataRef d = (CFMutableDataRef)CFArrayGetValueAtIndex(TUIGraphicsContextDataPool, i);
+			if((size_t)CFDataGetLength(d) == sizeClass) {
+				data = (CFMutableDataRef)CFRetain(d);
+				CFArrayRemoveValueAtIndex(TUIGraphicsContextDataPool, i);
+				TUIGraphicsContextDataPoolBytes -= sizeClass;
+				break;
+			}
+		}
+	}
+	OSSpinLockUnlock(&TUIGraphicsContextDataPoolLock);
+	
+	*reused = (data != NULL);
+	if(!data) {
+		data = CFDataCreateMutable(NULL, sizeClass);
+		CFDataSetLength(data, sizeClass);
+	}
+	return data;
+}
+
+void TUIRecycleGraphicsContextData(CFMutableDataRef data)
+{
+	if(!data)
+		return;
+	
+	OSSpinLockLock(&TUIGraphicsContextDataPoolLock);
+	if(TUIGraphicsContextDataGetImageCount(data) > 0) {
+		// images still show it, it isn't free (or counted against the limit) until they're gone
+		if(!TUIGraphicsContextDataWaiting)
+			TUIGraphicsContextDataWaiting = CFSetCreateMutable(NULL, 0, &kCFTypeSetCallBacks);
+		CFSetAddValue(TUIGraphicsContextDataWaiting, data);
+	} else {
+		TUIAddGraphicsContextDataToPool(data);
+	}
+	OSSpinLockUnlock(&TUIGraphicsContextDataPoolLock);
+}
+
+void TUISetGraphicsContextDataPoolByteLimit(size_t limit)
+{
+	OSSpinLockLock(&TUIGraphicsContextDataPoolLock);
+	TUIGraphicsContextDataPoolByteLimit = limit;
+	if(TUIGraphicsContextDataPool)
+		TUITrimGraphicsContextDataPool();
+	OSSpinLockUnlock(&TUIGraphicsContextDataPoolLock);
+}
+
+CGContextRef TUICreateGraphicsContextWithData(CGSize size, BOOL opaque, CFMutableDataRef *data)
+{
+	size_t width = size.width;
+	size_t height = size.height;
+	size_t bitsPerComponent = 8;
+	size_t bytesPerRow = 4 * width;
+	BOOL reused;
+	CFMutableDataRef d = TUICreateGraphicsContextDataFromPool(bytesPerRow * height, &reused);
+	if(reused)
+		memset(CFDataGetMutableBytePtr(d), 0, bytesPerRow * height);
+	CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGBitmapInfo bitmapInfo = kCGBitmapByteOrder32Host | (opaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst);
+	CGContextRef ctx = CGBitmapContextCreate(CFDataGetMutableBytePtr(d), width, height, bitsPerComponent, bytesPerRow, colorSpace, bitmapInfo);
+	CGColorSpaceRelease(colorSpace);
+	
+	if(ctx) {
+		*data = d;
+	} else {
+		TUIRecycleGraphicsContextData(d);
+		CFRelease(d);
+		*data = NULL;
+	}
+	return ctx;
+}
+
+// called on whatever thread lets go of the last image of a buffer
+static void TUIGraphicsContextDataImageReleased(void *info, const void *bytes, size_t size)
+{
+	CFMutableDataRef data = info;
+	
+	OSSpinLockLock(&TUIGraphicsContextDataPoolLock);
+	CFIndex count = TUIGraphicsContextDataGetImageCount(data) - 1;
+	if(count > 0) {
+		CFDictionarySetValue(TUIGraphicsContextDataImageCounts, data, (const void *)count);
+	} else {
+		CFDictionaryRemoveValue(TUIGraphicsContextDataImageCounts, data);
+		if(TUIGraphicsContextDataWaiting && CFSetContainsValue(TUIGraphicsContextDataWaiting, data)) {
+			TUIAddGraphicsContextDataToPool(data);
+			CFSetRemoveValue(TUIGraphicsContextDataWaiting, data);
+		}
+	}
+	OSSpinLockUnlock(&TUIGraphicsContextDataPoolLock);
+	
+	CFRelease(data);
+}
+
+CGImageRef TUICreateCGImageWithBitmapContextData(CGContextRef ctx, CFDataRef data)
+{
+	// The provider keeps data alive, so the image stays valid after the context
+	// is gone, and tells us when the image is, so we know when data is free.
+	OSSpinLockLock(&TUIGraphicsContextDataPoolLock);
+	if(!TUIGraphicsContextDataImageCounts)
+		TUIGraphicsContextDataImageCounts = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+	CFDictionarySetValue(TUIGraphicsContextDataImageCounts, data, (const void *)(TUIGraphicsContextDataGetImageCount(data) + 1));
+	OSSpinLockUnlock(&TUIGraphicsContextDataPoolLock);
+	
+	CFRetain(data);
+	CGDataProviderRef provider = CGDataProviderCreateWithData((void *)data, CFDataGetBytePtr(data), CFDataGetLength(data), TUIGraphicsContextDataImageReleased);
+	CGImageRef image = CGImageCreate(CGBitmapContextGetWidth(ctx),
+									 CGBitmapContextGetHeight(ctx),
+									 CGBitmapContextGetBitsPerComponent(ctx),
+									 CGBitmapContextGetBitsPerPixel(ctx),
+									 CGBitmapContextGetBytesPerRow(ctx),
+									 CGBitmapContextGetColorSpace(ctx),
+									 CGBitmapContextGetBitmapInfo(ctx),
+									 provider, NULL, false, kCGRenderingIntentDefault);
+	CGDataProviderRelease(provider);
+	return image;
+}
+
 CGPathRef TUICGPathCreateRoundedRect(CGRect rect, CGFloat radius) {
 	return TUICGPathCreateRoundedRectWithCorners(rect, radius, TUICGRoundedRectCornerAll);
 }
@@ -193,6 +372,39 @@ void TUIGraphicsPopContext(void)
 	[NSGraphicsContext restoreGraphicsState];
 }
 
+// holds a pointer to the innermost TUIDrawContext, which lives on the drawer's stack
+static pthread_key_t TUIDrawContextKey;
+static pthread_once_t TUIDrawContextKeyOnce = PTHREAD_ONCE_INIT;
+
+static void TUIDrawContextKeyCreate(void)
+{
+	pthread_key_create(&TUIDrawContextKey, NULL);
+}
+
+TUIDrawContext *TUIGraphicsGetCurrentDrawContext(void)
+{
+	pthread_once(&TUIDrawContextKeyOnce, TUIDrawContextKeyCreate);
+	return pthread_getspecific(TUIDrawContextKey);
+}
+
+void TUIGraphicsPushDrawContext(TUIDrawContext *drawContext)
+{
+	// AppKit drawing (NSString, NSImage, NSBezierPath...) still needs an NSGraphicsContext
+	TUIGraphicsPushContext(drawContext->context);
+	drawContext->previous = TUIGraphicsGetCurrentDrawContext();
+	pthread_setspecific(TUIDrawContextKey, drawContext);
+}
+
+void TUIGraphicsPopDrawContext(void)
+{
+	TUIDrawContext *drawContext = TUIGraphicsGetCurrentDrawContext();
+	if(!drawContext)
+		return;
+	
+	pthread_setspecific(TUIDrawContextKey, drawContext->previous);
+	TUIGraphicsPopContext();
+}
+
 NSImage *TUIGraphicsContextGetImage(CGContextRef ctx)
 {
 	CGImageRef CGImage = TUICreateCGImageFromBitmapContext(ctx);
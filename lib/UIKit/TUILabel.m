@@ -15,16 +15,20 @@
  */
 
 #import "TUILabel.h"
+#import "NSColor+TUIExtensions.h"
+#import "TUICGAdditions.h"
 #import "TUINSView.h"
 #import "TUITextRenderer.h"
 
 @interface TUILabel () {
 	struct {
 		unsigned int selectable:1;
+		unsigned int attributedStringFromText:1;
 	} _textLabelFlags;
 }
 
 - (void)_recreateAttributedString;
+- (BOOL)_drawTextLineInRect:(CGRect)rect;
 @end
 
 @implementation TUILabel
@@ -72,16 +76,54 @@
 }
 - (void)drawRect:(CGRect)rect
 {
-	if(renderer.attributedString == nil) {
-		[self _recreateAttributedString];
-	}
-	
 	[super drawRect:rect]; // draw background
 	CGRect bounds = self.bounds;
 	renderer.frame = CGRectMake(0, 0, bounds.size.width, bounds.size.height);
+	if([self _drawTextLineInRect:renderer.frame])
+		return;
+	
+	if(renderer.attributedString == nil) {
+		[self _recreateAttributedString];
+	}
 	[renderer draw];	
 }
 
+// Plain text that fits on one line is drawn from a shared, already shaped
+// line, without making an attributed string or laying out a frame. It ends up
+// where the renderer would put it.
+- (BOOL)_drawTextLineInRect:(CGRect)rect
+{
+	if(_text == nil || [self isSelectable] || renderer.verticalAlignment != TUITextVerticalAlignmentMiddle)
+		return NO;
+	if(renderer.attributedString != nil && !_textLabelFlags.attributedStringFromText)
+		return NO;
+	if([_text rangeOfCharacterFromSet:[NSCharacterSet newlineCharacterSet]].location != NSNotFound)
+		return NO;
+	
+	TUITextLine *line = [TUITextLine lineForString:_text font:_font color:_textColor kerning:0.0f];
+	CGFloat height = ceil(line.ascent + line.descent);
+	if(ceil(line.width) > rect.size.width || height > rect.size.height)
+		return NO; // wraps, truncates or is cut off
+	
+	CGFloat flush = 0.0f;
+	if(_alignment == TUITextAlignmentCenter)
+		flush = 0.5f;
+	else if(_alignment == TUITextAlignmentRight)
+		flush = 1.0f;
+	
+	CGPoint baseline;
+	baseline.x = rect.origin.x + CTLineGetPenOffsetForFlush(line.ctLine, flush, rect.size.width);
+	baseline.y = CGRectGetMaxY(rect) - line.ascent - roundf((rect.size.height - height) / 2);
+	
+	CGContextRef context = TUIGraphicsGetCurrentContext();
+	CGContextSaveGState(context);
+	if(renderer.shadowColor)
+		CGContextSetShadowWithColor(context, renderer.shadowOffset, renderer.shadowBlur, renderer.shadowColor.tui_CGColor);
+	[line drawAtPoint:baseline inContext:context];
+	CGContextRestoreGState(context);
+	return YES;
+}
+
 - (void)_update
 {
 	[self setNeedsDisplay];
@@ -98,6 +140,7 @@
 
 - (void)setAttributedString:(NSAttributedString *)a
 {
+	_textLabelFlags.attributedStringFromText = 0;
 	renderer.attributedString = a;
 	[self _update];
 }
@@ -111,6 +154,7 @@
 	if(_textColor != nil) newAttributedString.color = _textColor;
 	[newAttributedString setAlignment:self.alignment lineBreakMode:self.lineBreakMode];
 	self.attributedString = newAttributedString;
+	_textLabelFlags.attributedStringFromText = 1;
 }
 
 - (BOOL)isSelectable
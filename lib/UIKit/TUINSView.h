@@ -39,6 +39,9 @@
 	BOOL deliveringEvent;
 	BOOL inLiveResize;
 	
+	TUIView *_scrollWheelTarget;
+	CFAbsoluteTime _scrollWheelTargetTimestamp;
+	
 	BOOL opaque;
 }
 
@@ -25,6 +25,8 @@
 #import "TUINSView+Private.h"
 #import "TUIViewNSViewContainer.h"
 #import "TUITooltipWindow.h"
+#import "TUIScrollView+Private.h"
+#import "TUIView+Private.h"
 
 // If enabled, NSViews contained within TUIViewNSViewContainers will be clipped
 // by any TwUI ancestors that enable clipping to bounds.
@@ -390,6 +392,9 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 	} else {
 		[_hoverView mouseMoved:event];
 	}
+	
+	// only the view under the mouse hover tests its text, superviews hear about moves too but their text is covered
+	[_hoverView _updateHoveredTextRenderersWithEvent:event];
 }
 
 - (void)_updateHoverViewWithEvent:(NSEvent *)event
@@ -487,20 +492,39 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 	[lastTrackingView rightMouseUp:event]; // after trackingView is set to nil, will call mouseUp:fromSubview:
 }
 
+/**
+ * @internal
+ * @brief Obtain the view that should receive a scroll wheel event
+ *
+ * Hit testing sorts the subviews of every view on the way down, which is a lot
+ * of work to repeat for each of the many events in a scroll. The target is
+ * found when a gesture begins, and the rest of the gesture goes to the same view.
+ */
+- (TUIView *)_scrollWheelTargetForEvent:(NSEvent *)event
+{
+	if (_scrollWheelTarget == nil || _scrollWheelTarget.nsView != self || TUIScrollWheelEventBeginsGesture(event, _scrollWheelTargetTimestamp))
+		_scrollWheelTarget = [self viewForEvent:event];
+	_scrollWheelTargetTimestamp = CFAbsoluteTimeGetCurrent();
+	return _scrollWheelTarget;
+}
+
 - (void)scrollWheel:(NSEvent *)event
 {
-	[[self viewForEvent:event] scrollWheel:event];
+	[[self _scrollWheelTargetForEvent:event] scrollWheel:event];
 	[self _updateHoverView:nil withEvent:event]; // don't pop in while scrolling
 }
 
 - (void)beginGestureWithEvent:(NSEvent *)event
 {
-	[[self viewForEvent:event] beginGestureWithEvent:event];
+	_scrollWheelTarget = [self viewForEvent:event];
+	_scrollWheelTargetTimestamp = CFAbsoluteTimeGetCurrent();
+	[_scrollWheelTarget beginGestureWithEvent:event];
 }
 
 - (void)endGestureWithEvent:(NSEvent *)event
 {
-	[[self viewForEvent:event] endGestureWithEvent:event];
+	TUIView *target = (_scrollWheelTarget.nsView == self) ? _scrollWheelTarget : [self viewForEvent:event];
+	[target endGestureWithEvent:event];
 }
 
 - (void)magnifyWithEvent:(NSEvent *)event
@@ -4,6 +4,12 @@
 // Required by both TUIScroller and TUIScrollView.
 static NSTimeInterval const TUIScrollerFadeSpeed = 0.25f;
 
+// Whether a scroll wheel event starts a new scroll gesture, rather than
+// continuing the one whose previous event arrived at lastEventTime. Events
+// without phase information (plain mouse wheels, pre-10.7) start a new
+// gesture after a short pause.
+extern BOOL TUIScrollWheelEventBeginsGesture(NSEvent *event, CFAbsoluteTime lastEventTime);
+
 @interface TUIScrollView ()
 
 + (BOOL)requiresLegacyScrollers;
@@ -15,6 +21,12 @@ static NSTimeInterval const TUIScrollerFadeSpeed = 0.25f;
 - (void)_updateScrollers;
 - (void)_updateScrollersAnimated:(BOOL)animated;
 
+// Continuous scrolling for drags. Subclasses may override
+// -_continuousScrollDidTick to do per-frame work while a drag
+// scroll is running; it's called once per display link tick.
+- (BOOL)_isScrollingContinuously;
+- (void)_continuousScrollDidTick;
+
 @end
 
 @interface TUIScroller ()
@@ -25,4 +37,7 @@ static NSTimeInterval const TUIScrollerFadeSpeed = 0.25f;
 - (void)anchorScroller;
 - (void)forceDisableExpandedScroller:(BOOL)expand;
 
+- (void)invalidateGeometry;
+- (void)redrawTrackIfNeeded;
+
 @end
\ No newline at end of file
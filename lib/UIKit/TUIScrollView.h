@@ -80,6 +80,7 @@ typedef enum {
 	__unsafe_unretained id _delegate;
 	
 	CVDisplayLinkRef displayLink;
+	volatile int32_t _displayLinkTickPending;
 	CGPoint destinationOffset;
 	CGPoint unfixedContentOffset;
 	
@@ -91,6 +92,20 @@ typedef enum {
 		CFAbsoluteTime t;
 	} _lastScroll;
 	
+	struct {
+		double dx;
+		double dy;
+		CFAbsoluteTime t;
+		BOOL pending;
+	} _wheel;
+	
+	struct {
+		CFAbsoluteTime t;
+		BOOL decided;
+		BOOL handingOff;
+		BOOL dragging; // told the delegate it began dragging, not yet that it ended
+	} _scrollChain;
+	
 	struct {
 		float vx;
 		float vy;
@@ -116,6 +131,11 @@ typedef enum {
 	
 	CGPoint  _dragScrollLocation;
 	
+	struct {
+		CFAbsoluteTime began;
+		CFAbsoluteTime t;
+	} _continuousScroll;
+	
 	BOOL x;
 	
 	struct {
@@ -127,7 +147,7 @@ typedef enum {
 		unsigned int mouseDownInScroller:1;
 		unsigned int ignoreNextScrollPhaseNormal_10_7:1;
 		unsigned int gestureBegan:1;
-		unsigned int animationMode:2;
+		unsigned int animationMode:3;
 		unsigned int scrollDisabled:1;
 		unsigned int scrollIndicatorStyle:2;
 		unsigned int verticalScrollIndicatorVisibility:2;
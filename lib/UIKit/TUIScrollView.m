@@ -15,6 +15,7 @@
  */
 
 #import <CoreServices/CoreServices.h>
+#import <libkern/OSAtomic.h>
 #import "TUIScrollView+Private.h"
 #import "TUIKit.h"
 #import "TUIScroller.h"
@@ -24,7 +25,19 @@
 #define FORCE_ENABLE_BOUNCE 1
 
 #define TUIScrollViewContinuousScrollDragBoundary 25.0
-#define TUIScrollViewContinuousScrollRate 10.0
+// points per second at the very edge of the drag boundary
+#define TUIScrollViewContinuousScrollRate 600.0
+// the rate ramps up from 1x to this multiple the longer a drag is held at the edge
+#define TUIScrollViewContinuousScrollMaximumAcceleration 3.0
+#define TUIScrollViewContinuousScrollAccelerationDuration 2.0
+// longest frame interval we'll integrate over, so a stall doesn't cause a jump
+#define TUIScrollViewContinuousScrollMaximumTickInterval (1.0 / 15.0)
+
+// how long the display link keeps running after the last scroll wheel event
+#define TUIScrollViewScrollWheelIdleInterval 0.25
+
+// pause after which phaseless scroll wheel events start a new gesture
+#define TUIScrollViewScrollGestureLatchInterval 0.3
 
 enum {
 	ScrollPhaseNormal = 0,
@@ -38,6 +51,7 @@ enum {
 	AnimationModeThrow,
 	AnimationModeScrollTo,
 	AnimationModeScrollContinuous,
+	AnimationModeScrollWheel,
 };
 
 @interface TUIScrollView ()
@@ -52,9 +66,35 @@ enum {
 - (void)_updateScrollersAnimated:(BOOL)animated;
 - (void)_updateBounce;
 - (void)_startDisplayLink:(int)scrollMode;
+- (void)_applyPendingScrollWheelDelta;
 
 @end
 
+BOOL TUIScrollWheelEventBeginsGesture(NSEvent *event, CFAbsoluteTime lastEventTime) {
+	NSInteger phase = 0;
+	NSInteger momentumPhase = 0;
+	
+	SEL s = @selector(phase);
+	if ([event respondsToSelector:s]) {
+		NSInteger (*imp)(id,SEL) = (NSInteger(*)(id,SEL))[event methodForSelector:s];
+		phase = imp(event, s);
+	}
+	s = @selector(momentumPhase);
+	if ([event respondsToSelector:s]) {
+		NSInteger (*imp)(id,SEL) = (NSInteger(*)(id,SEL))[event methodForSelector:s];
+		momentumPhase = imp(event, s);
+	}
+	
+	// momentum belongs to whichever gesture started it
+	if (momentumPhase != 0)
+		return NO;
+	// began (1) or may begin (32)
+	if (phase != 0)
+		return (phase & (1 | 32)) != 0;
+	
+	return (CFAbsoluteTimeGetCurrent() - lastEventTime) > TUIScrollViewScrollGestureLatchInterval;
+}
+
 @implementation TUIScrollView
 
 @synthesize decelerationRate;
@@ -259,6 +299,8 @@ static BOOL isAtleastMountainLion = NO;
 {
 	if (!TUIEdgeInsetsEqualToEdgeInsets(i, _contentInset)) {
 		_contentInset = i;
+		[self.verticalScroller invalidateGeometry];
+		[self.horizontalScroller invalidateGeometry];
 		if (self._pulling){
 			_scrollViewFlags.didChangeContentInset = 1;
 		}else if (!self.dragging) {
@@ -293,15 +335,22 @@ static BOOL isAtleastMountainLion = NO;
 static CVReturn scrollCallback(CVDisplayLinkRef displayLink, const CVTimeStamp *now, const CVTimeStamp *outputTime, CVOptionFlags flagsIn, CVOptionFlags *flagsOut, void *displayLinkContext)
 {
 	@autoreleasepool {
-		// perform drawing on the main thread
+		// perform drawing on the main thread. if the main thread hasn't gotten
+		// around to the previous tick yet, don't queue up another one behind it;
+		// each tick works from the elapsed time, so the pending one catches up.
 		TUIScrollView *scrollView = (__bridge id)displayLinkContext;
-		[scrollView performSelectorOnMainThread:@selector(tick) withObject:nil waitUntilDone:NO];
+		if (OSAtomicCompareAndSwap32Barrier(0, 1, &scrollView->_displayLinkTickPending))
+			[scrollView performSelectorOnMainThread:@selector(tick) withObject:nil waitUntilDone:NO];
 	}
 	return kCVReturnSuccess;
 }
 
 - (void)_startDisplayLink:(int)scrollMode
 {
+	// don't drop scroll wheel deltas that haven't been applied yet
+	if (_scrollViewFlags.animationMode == AnimationModeScrollWheel && scrollMode != AnimationModeScrollWheel)
+		[self _applyPendingScrollWheelDelta];
+	
 	_scrollViewFlags.animationMode = scrollMode;
 	_throw.t = CFAbsoluteTimeGetCurrent();
 	_bounce.bouncing = NO;
@@ -316,6 +365,9 @@ static CVReturn scrollCallback(CVDisplayLinkRef displayLink, const CVTimeStamp *
 
 - (void)_stopDisplayLink
 {
+	if (_scrollViewFlags.animationMode == AnimationModeScrollWheel)
+		[self _applyPendingScrollWheelDelta];
+	
 	if (displayLink) {
 		CVDisplayLinkStop(displayLink);
 	}
@@ -522,12 +574,10 @@ static CVReturn scrollCallback(CVDisplayLinkRef displayLink, const CVTimeStamp *
 		if (animated)
 			updateBlock();
 		
-		// If the scrollers aren't expanded, there's no need to draw them.
-		// Each animated redraw operation is just more toll, less scroll.
-		if (self.verticalScroller.expanded)
-			[self.verticalScroller redraw];
-		if (self.horizontalScroller.expanded)
-			[self.horizontalScroller redraw];
+		// Each animated redraw operation is just more toll, less scroll,
+		// so the scrollers only redraw if their track actually changed.
+		[self.verticalScroller redrawTrackIfNeeded];
+		[self.horizontalScroller redrawTrackIfNeeded];
 	}];
 	
 	// Notify the delegate about changes in scroll indiciator visibility.
@@ -652,6 +702,10 @@ static CGPoint PointLerp(CGPoint a, CGPoint b, CGFloat t)
 	p.x = round(-p.x - self.bounceOffset.x - self.pullOffset.x);
 	p.y = round(-p.y - self.bounceOffset.y - self.pullOffset.y);
 	[((CAScrollLayer *)self.layer) scrollToPoint:p];
+	if (TUIViewWantsScrollUpdates()) {
+		// tiled views and views waiting to redraw need to know what's visible now
+		[self.subviews makeObjectsPerformSelector:@selector(ancestorDidLayout)];
+	}
 	if (_scrollViewFlags.delegateScrollViewDidScroll){
 		[_delegate scrollViewDidScroll:self];
 	}
@@ -669,6 +723,10 @@ static CGPoint PointLerp(CGPoint a, CGPoint b, CGFloat t)
 
 - (void)setContentSize:(CGSize)s
 {
+	if (!CGSizeEqualToSize(s, _contentSize)) {
+		[self.verticalScroller invalidateGeometry];
+		[self.horizontalScroller invalidateGeometry];
+	}
 	_contentSize = s;
 }
 
@@ -796,8 +854,12 @@ static CGPoint PointLerp(CGPoint a, CGPoint b, CGFloat t)
 	if (dragLocation.y <= TUIScrollViewContinuousScrollDragBoundary || dragLocation.y >= (self.bounds.size.height - TUIScrollViewContinuousScrollDragBoundary)){
 		// note the drag offset
 		_dragScrollLocation = dragLocation;
-		// begin a continuous scroll
-		[self _startDisplayLink:AnimationModeScrollContinuous];
+		// begin a continuous scroll, unless we're already running one; the
+		// acceleration is based on how long we've been scrolling
+		if (_scrollViewFlags.animationMode != AnimationModeScrollContinuous) {
+			[self _startDisplayLink:AnimationModeScrollContinuous];
+			_continuousScroll.began = _continuousScroll.t = CFAbsoluteTimeGetCurrent();
+		}
 	}else{
 		[self endContinuousScrollAnimated:animated];
 	}
@@ -877,8 +939,18 @@ static float clampBounce(float x) {
 	}
 }
 
+- (BOOL)_isScrollingContinuously {
+	return _scrollViewFlags.animationMode == AnimationModeScrollContinuous;
+}
+
+- (void)_continuousScrollDidTick {
+	// for subclasses
+}
+
 - (void)tick
 {
+	OSAtomicCompareAndSwap32Barrier(1, 0, &_displayLinkTickPending);
+	
 	[self _updateBounce]; // can't do after _startBounce otherwise dt will be crazy
 	
 	if (self.nsWindow == nil) {
@@ -934,8 +1006,8 @@ static float clampBounce(float x) {
 			break;
 		}
 		case AnimationModeScrollContinuous: {
-			CGFloat direction;
-			CGFloat distance;
+			CGFloat direction = 0;
+			CGFloat distance = TUIScrollViewContinuousScrollDragBoundary;
 			
 			if (_dragScrollLocation.y <= TUIScrollViewContinuousScrollDragBoundary){
 				distance = MAX(0, MIN(TUIScrollViewContinuousScrollDragBoundary, _dragScrollLocation.y));
@@ -943,16 +1015,37 @@ static float clampBounce(float x) {
 			}else if (_dragScrollLocation.y >= (self.bounds.size.height - TUIScrollViewContinuousScrollDragBoundary)){
 				distance = MAX(0, MIN(TUIScrollViewContinuousScrollDragBoundary, self.bounds.size.height - _dragScrollLocation.y));
 				direction = -1;
-			}else{
-				return; // no scrolling; outside drag boundary
 			}
 			
-			CGPoint offset = _unroundedContentOffset;
-			CGFloat step = (1.0 - (distance / TUIScrollViewContinuousScrollDragBoundary)) * TUIScrollViewContinuousScrollRate;
-			CGPoint dest = CGPointMake(offset.x, offset.y + (step * direction));
+			// advance by elapsed time rather than by tick, so the scroll speed
+			// doesn't depend on the refresh rate or on dropped frames.
+			CFAbsoluteTime t = CFAbsoluteTimeGetCurrent();
+			double dt = MIN(t - _continuousScroll.t, TUIScrollViewContinuousScrollMaximumTickInterval);
+			_continuousScroll.t = t;
 			
-			[self setContentOffset:dest];
+			if (direction != 0) {
+				// ease in with the depth of the drag into the boundary, and
+				// accelerate the longer the drag is held there.
+				CGFloat depth = 1.0 - (distance / TUIScrollViewContinuousScrollDragBoundary);
+				CGFloat held = MIN(1.0, (t - _continuousScroll.began) / TUIScrollViewContinuousScrollAccelerationDuration);
+				CGFloat acceleration = 1.0 + (TUIScrollViewContinuousScrollMaximumAcceleration - 1.0) * held * held;
+				CGFloat step = depth * depth * TUIScrollViewContinuousScrollRate * acceleration * dt;
+				
+				CGPoint offset = _unroundedContentOffset;
+				[self setContentOffset:CGPointMake(offset.x, offset.y + (step * direction))];
+			}
 			
+			[self _continuousScrollDidTick];
+			break;
+		}
+		case AnimationModeScrollWheel: {
+			// apply everything that arrived since the last frame at once, and
+			// wind down the display link once the wheel has been idle a while.
+			if (_wheel.pending) {
+				[self _applyPendingScrollWheelDelta];
+			} else if (CFAbsoluteTimeGetCurrent() - _wheel.t > TUIScrollViewScrollWheelIdleInterval) {
+				[self _stopDisplayLink];
+			}
 			break;
 		}
 	}
@@ -1046,6 +1139,11 @@ static float clampBounce(float x) {
 - (void)beginGestureWithEvent:(NSEvent *)event
 {
 	
+	// whether this gesture is ours is decided by its first scroll event
+	_scrollChain.decided = NO;
+	_scrollChain.handingOff = NO;
+	_scrollChain.dragging = YES;
+	
 	if (_scrollViewFlags.delegateScrollViewWillBeginDragging){
 		[_delegate scrollViewWillBeginDragging:self];
 	}
@@ -1059,6 +1157,7 @@ static float clampBounce(float x) {
 
 - (void)_startThrow
 {
+	[self _applyPendingScrollWheelDelta];
 	
 	if (!self._pulling){
 		if (fabsf(_lastScroll.dy) < 2.0 && fabsf(_lastScroll.dx) < 2.0){
@@ -1110,11 +1209,19 @@ static float clampBounce(float x) {
 - (void)endGestureWithEvent:(NSEvent *)event
 {
 	
+	if (_scrollChain.handingOff) {
+		[super endGestureWithEvent:event];
+		return;
+	}
+	
+	_scrollChain.dragging = NO;
 	if (_scrollViewFlags.delegateScrollViewDidEndDragging){
 		[_delegate scrollViewDidEndDragging:self];
 	}
 	
 	if (_scrollViewFlags.bounceEnabled) {
+		// the last batched delta still belongs to the gesture, so it can pull
+		[self _applyPendingScrollWheelDelta];
 		_scrollViewFlags.gestureBegan = 0;
 		[self _startThrow];
 		
@@ -1125,8 +1232,154 @@ static float clampBounce(float x) {
 	
 }
 
+- (void)_applyPendingScrollWheelDelta
+{
+	if (!_wheel.pending)
+		return;
+	
+	double dx = _wheel.dx;
+	double dy = _wheel.dy;
+	_wheel.dx = 0.0;
+	_wheel.dy = 0.0;
+	_wheel.pending = NO;
+	
+	CGPoint o = _unroundedContentOffset;
+	
+	if (!_pull.xPulling) o.x = o.x + dx;
+	if (!_pull.yPulling) o.y = o.y - dy;
+	
+	BOOL xPulling = NO;
+	BOOL yPulling = NO;
+	{
+		CGPoint pull = o;
+		pull.x += ((_pull.xPulling) ? _pull.x : 0);
+		pull.y += ((_pull.yPulling) ? _pull.y : 0);
+		CGPoint fixedOffset = [self _fixProposedContentOffset:pull];
+		o.x = fixedOffset.x;
+		o.y = fixedOffset.y;
+		xPulling = fixedOffset.x != pull.x;
+		yPulling = fixedOffset.y != pull.y;
+	}
+	
+	if (_scrollViewFlags.gestureBegan){
+		float maxManualPull = 30.0;
+	
+		if (_pull.xPulling){
+			CGFloat xCounter = pow(M_E, -1.0 / maxManualPull * fabsf(_pull.x));
+			// don't counter on un-pull
+			if (signbit(_pull.x) != signbit(dx))
+				xCounter = 1;
+			// update x-axis pulling
+			if (xPulling)
+				_pull.x += dx * xCounter;
+		}else if (xPulling){
+			_pull.x = dx;
+		}
+	
+		if (_pull.yPulling){
+			CGFloat yCounter = pow(M_E, -1.0 / maxManualPull * fabsf(_pull.y));
+			// don't counter on un-pull
+			if (signbit(_pull.y) == signbit(dy))
+				yCounter = 1; // don't counter
+			// update y-axis pulling
+			if (yPulling)
+				_pull.y -= dy * yCounter;
+		}else if (yPulling){
+			_pull.y = -dy;
+		}
+	
+		_pull.xPulling = xPulling;
+		_pull.yPulling = yPulling;
+	}
+	
+	[self setContentOffset:o];
+}
+
+- (BOOL)_canScrollHorizontally:(BOOL)horizontal
+{
+	if (!self.scrollEnabled)
+		return NO;
+	return horizontal ?
+		(_scrollViewFlags.alwaysBounceHorizontal || [self _horizontalScrollerNeededForContentSize:self.contentSize]) :
+		(_scrollViewFlags.alwaysBounceVertical || [self _verticalScrollerNeededForContentSize:self.contentSize]);
+}
+
+// the nearest scroll view around us that can take a gesture along that axis,
+// e.g. not the horizontal pager a vertical table sits in
+- (TUIScrollView *)_enclosingScrollViewScrollingHorizontally:(BOOL)horizontal
+{
+	for (TUIView *v = self.superview; v != nil; v = v.superview) {
+		if ([v isKindOfClass:[TUIScrollView class]] && [(TUIScrollView *)v _canScrollHorizontally:horizontal])
+			return (TUIScrollView *)v;
+	}
+	return nil;
+}
+
+/**
+ * @internal
+ * @brief Determine if a scroll wheel event should go to an enclosing view
+ *
+ * The decision is made once per gesture, from its first event that actually
+ * moves: the gesture is handed off if we can't scroll along its main axis at
+ * all, or if we're already at the edge in that direction and an enclosing
+ * scroll view can take it from there.
+ *
+ * @return hand off or not
+ */
+- (BOOL)_shouldHandOffScrollWheelEvent:(NSEvent *)event
+{
+	if (TUIScrollWheelEventBeginsGesture(event, _scrollChain.t)) {
+		_scrollChain.decided = NO;
+		_scrollChain.handingOff = NO;
+	}
+	_scrollChain.t = CFAbsoluteTimeGetCurrent();
+	
+	if (_scrollChain.decided)
+		return _scrollChain.handingOff;
+	
+	CGEventRef cgEvent = [event CGEvent];
+	double dx = CGEventGetDoubleValueField(cgEvent, kCGScrollWheelEventPointDeltaAxis2);
+	double dy = CGEventGetDoubleValueField(cgEvent, kCGScrollWheelEventPointDeltaAxis1);
+	if (dx == 0.0 && dy == 0.0)
+		return NO; // not enough to go on yet
+	
+	BOOL horizontal = fabs(dx) > fabs(dy);
+	BOOL canScroll = horizontal ?
+		(_scrollViewFlags.alwaysBounceHorizontal || [self _horizontalScrollerNeededForContentSize:self.contentSize]) :
+		(_scrollViewFlags.alwaysBounceVertical || [self _verticalScrollerNeededForContentSize:self.contentSize]);
+	
+	BOOL handOff = !canScroll;
+	if (!handOff && [self _enclosingScrollViewScrollingHorizontally:horizontal] != nil) {
+		CGPoint o = _unroundedContentOffset;
+		CGPoint proposed = CGPointMake(o.x + dx, o.y - dy);
+		CGPoint fixed = [self _fixProposedContentOffset:proposed];
+		handOff = horizontal ? (roundf(fixed.x) == roundf(o.x)) : (roundf(fixed.y) == roundf(o.y));
+	}
+	
+	_scrollChain.decided = YES;
+	_scrollChain.handingOff = handOff;
+	
+	if (handOff && _scrollChain.dragging) {
+		// the enclosing view is the one being dragged now, not us
+		_scrollChain.dragging = NO;
+		if (_scrollViewFlags.delegateScrollViewDidEndDragging)
+			[_delegate scrollViewDidEndDragging:self];
+	}
+	if (handOff && _scrollViewFlags.gestureBegan) {
+		_scrollViewFlags.gestureBegan = 0;
+		[super beginGestureWithEvent:event];
+	}
+	
+	return handOff;
+}
+
 - (void)scrollWheel:(NSEvent *)event
 {
+	if ([self _shouldHandOffScrollWheelEvent:event]) {
+		[super scrollWheel:event];
+		return;
+	}
+	
 	if (_contentSize.height <= CGRectGetHeight(self.bounds)) {
 		[super scrollWheel:event];
 	}
@@ -1172,7 +1425,13 @@ static float clampBounce(float x) {
 				_throw.throwing = 0;
 				_scrollViewFlags.didChangeContentInset = 0;
 				
-				[self _stopDisplayLink];
+				// the first event of a scroll stops whatever else was animating, and
+				// starts the display link that applies the batched deltas each frame
+				if (_scrollViewFlags.animationMode != AnimationModeScrollWheel) {
+					[self _stopDisplayLink];
+					[self _startDisplayLink:AnimationModeScrollWheel];
+				}
+				
 				CGEventRef cgEvent = [event CGEvent];
 				const int64_t isContinuous = CGEventGetIntegerValueField(cgEvent, kCGScrollWheelEventIsContinuous);
 				
@@ -1205,56 +1464,12 @@ static float clampBounce(float x) {
 					_lastScroll.t = CFAbsoluteTimeGetCurrent();
 				}
 				
-				CGPoint o = _unroundedContentOffset;
-				
-				if (!_pull.xPulling) o.x = o.x + dx;
-				if (!_pull.yPulling) o.y = o.y - dy;
-				
-				BOOL xPulling = NO;
-				BOOL yPulling = NO;
-				{
-					CGPoint pull = o;
-					pull.x += ((_pull.xPulling) ? _pull.x : 0);
-					pull.y += ((_pull.yPulling) ? _pull.y : 0);
-					CGPoint fixedOffset = [self _fixProposedContentOffset:pull];
-					o.x = fixedOffset.x;
-					o.y = fixedOffset.y;
-					xPulling = fixedOffset.x != pull.x;
-					yPulling = fixedOffset.y != pull.y;
-				}
-				
-				if (_scrollViewFlags.gestureBegan){
-					float maxManualPull = 30.0;
-					
-					if (_pull.xPulling){
-						CGFloat xCounter = pow(M_E, -1.0 / maxManualPull * fabsf(_pull.x));
-						// don't counter on un-pull
-						if (signbit(_pull.x) != signbit(dx))
-							xCounter = 1;
-						// update x-axis pulling
-						if (xPulling)
-							_pull.x += dx * xCounter;
-					}else if (xPulling){
-						_pull.x = dx;
-					}
-					
-					if (_pull.yPulling){
-						CGFloat yCounter = pow(M_E, -1.0 / maxManualPull * fabsf(_pull.y));
-						// don't counter on un-pull
-						if (signbit(_pull.y) == signbit(dy))
-							yCounter = 1; // don't counter
-						// update y-axis pulling
-						if (yPulling)
-							_pull.y -= dy * yCounter;
-					}else if (yPulling){
-						_pull.y = -dy;
-					}
-					
-					_pull.xPulling = xPulling;
-					_pull.yPulling = yPulling;
-				}
-				
-				[self setContentOffset:o];
+				// Some devices deliver many events per frame; rather than scroll (and
+				// lay out) for each of them, batch them up for the next tick.
+				_wheel.dx += dx;
+				_wheel.dy += dy;
+				_wheel.t = CFAbsoluteTimeGetCurrent();
+				_wheel.pending = YES;
 				break;
 			}
 			case ScrollPhaseThrowingBegan: {
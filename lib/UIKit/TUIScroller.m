@@ -48,6 +48,24 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 		unsigned flashing:1;
 		unsigned forcedDisableExpand:1;
 	} _scrollerFlags;
+	
+	// Geometry which only depends on the track size and the scroll view's
+	// content and visible sizes. It is recomputed only when those change,
+	// not for every change in content offset.
+	struct {
+		CGSize trackSize;
+		CGSize contentSize;
+		CGSize visibleSize;
+		CGFloat knobLength;
+		CGFloat maximumContentOffset;
+		unsigned valid:1;
+	} _geometry;
+	
+	// The last state the knob and track were updated for, so
+	// unchanged layout passes don't touch the layers.
+	CGRect _lastKnobFrame;
+	CGFloat _lastKnobCornerRadius;
+	CGSize _lastDrawnTrackSize;
 }
 
 @property (nonatomic, assign, getter = isKnobHidden) BOOL knobHidden;
@@ -61,6 +79,8 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 
 - (void)_hideKnob;
 - (void)_refreshKnobTimer;
+- (void)_updateGeometryForVisibleSize:(CGSize)visibleSize;
+- (CGFloat)_knobOffsetForLength:(CGFloat)knobLength visibleOrigin:(CGPoint)visibleOrigin;
 - (void)_updateKnobAlphaWithSpeed:(CGFloat)speed;
 
 @end
@@ -185,14 +205,104 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 	
 	// Adjust the anchor points so if the scroll knob expands, it
 	// expands outwards left/up. Set our anchor point to match this.
-	self.layer.anchorPoint = self.vertical ? CGPointMake(1.0, 0.5) : CGPointMake(0.5, 0.0);
-	self.knob.layer.anchorPoint = self.vertical ? CGPointMake(1.0, 0.5) : CGPointMake(0.5, 0.0);
+	CGPoint anchorPoint = self.vertical ? CGPointMake(1.0, 0.5) : CGPointMake(0.5, 0.0);
+	if (CGPointEqualToPoint(anchorPoint, self.knob.layer.anchorPoint))
+		return;
+	
+	self.layer.anchorPoint = anchorPoint;
+	self.knob.layer.anchorPoint = anchorPoint;
+	
+	// Moving the anchor moves the knob, so it needs to be laid out again.
+	_lastKnobFrame = CGRectNull;
+}
+
+- (void)invalidateGeometry {
+	_geometry.valid = 0;
+}
+
+- (void)redrawTrackIfNeeded {
+	// If the scrollers aren't expanded, there's no need to draw them.
+	// Otherwise the track only depends on its size, not on the knob
+	// position, so don't redraw it as the content scrolls.
+	if (!self.expanded) {
+		_lastDrawnTrackSize = CGSizeZero;
+		return;
+	}
+	
+	if (CGSizeEqualToSize(self.bounds.size, _lastDrawnTrackSize))
+		return;
+	
+	_lastDrawnTrackSize = self.bounds.size;
+	[self redraw];
+}
+
+- (void)_updateGeometryForVisibleSize:(CGSize)visibleSize {
+	CGSize trackSize = self.bounds.size;
+	CGSize contentSize = self.scrollView.contentSize;
+	
+	if (_geometry.valid &&
+		CGSizeEqualToSize(trackSize, _geometry.trackSize) &&
+		CGSizeEqualToSize(contentSize, _geometry.contentSize) &&
+		CGSizeEqualToSize(visibleSize, _geometry.visibleSize))
+		return;
+	
+	CGFloat knobLength;
+	if (self.vertical) {
+		knobLength = trackSize.height * (visibleSize.height / contentSize.height);
+		_geometry.maximumContentOffset = contentSize.height - visibleSize.height;
+	} else {
+		knobLength = trackSize.width * (visibleSize.width / contentSize.width);
+		_geometry.maximumContentOffset = contentSize.width - visibleSize.width;
+	}
+	
+	if (knobLength < TUIScrollerMinimumKnobSize)
+		knobLength = TUIScrollerMinimumKnobSize;
+	if (isnan(knobLength))
+		knobLength = 0.0;
+	
+	_geometry.knobLength = knobLength;
+	_geometry.trackSize = trackSize;
+	_geometry.contentSize = contentSize;
+	_geometry.visibleSize = visibleSize;
+	_geometry.valid = 1;
+}
+
+- (CGFloat)_knobOffsetForLength:(CGFloat)knobLength visibleOrigin:(CGPoint)visibleOrigin {
+	CGSize trackSize = _geometry.trackSize;
+	CGFloat maxOffset = _geometry.maximumContentOffset;
+	
+	CGFloat rangeOfMotion, currentOffset, trackLength;
+	if (self.vertical) {
+		trackLength = trackSize.height;
+		currentOffset = visibleOrigin.y;
+	} else {
+		trackLength = trackSize.width;
+		currentOffset = visibleOrigin.x;
+	}
+	rangeOfMotion = trackLength - knobLength;
+	
+	CGFloat offsetProportion = 1.0 - (maxOffset - currentOffset) / maxOffset;
+	CGFloat knobOffset = offsetProportion * rangeOfMotion;
+	
+	if (isnan(knobOffset))
+		knobOffset = 0.0f;
+	else if (knobOffset + knobLength > trackLength)
+		knobOffset = trackLength - knobLength;
+	else if (knobOffset < 0.0f)
+		knobOffset = 0.0f;
+	
+	return knobOffset;
 }
 
 - (void)layoutSubviews {
+	// Compute the offset-independent geometry only if it's stale, and
+	// everything that depends on the offset in a single pass.
+	CGRect visible = self.scrollView.visibleRect;
+	[self _updateGeometryForVisibleSize:visible.size];
+	
 	CGFloat oldKnobWidth;
-	CGFloat knobLength = MIN(2000, [self adjustedKnobWidth]);
-	CGFloat knobOffset = [self adjustedKnobOffsetForWidth:knobLength];
+	CGFloat knobLength = MIN(2000, _geometry.knobLength);
+	CGFloat knobOffset = [self _knobOffsetForLength:knobLength visibleOrigin:visible.origin];
 	
 	// Calculate the proper overscroll and squish the knob by that much.
 	CGFloat bounce;
@@ -213,22 +323,32 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 	// Get the new scroller frame and set the scroller position, so
 	// if we are expanding the scroller, it doesn't jump, but expands.
 	CGRect frame = CGRectZero;
+	CGFloat scrollerWidth = self.updatedScrollerWidth;
+	CGFloat cornerRadius = self.updatedScrollerCornerRadius;
 	if (self.vertical) {
-		oldKnobWidth = self.knob.frame.size.width;
-		frame = CGRectMake(TUIScrollerKnobInset, knobOffset, self.updatedScrollerWidth - TUIScrollerKnobInset, knobLength);
+		frame = CGRectMake(TUIScrollerKnobInset, knobOffset, scrollerWidth - TUIScrollerKnobInset, knobLength);
 		frame = CGRectInset(frame, 2, 3);
-		
-		self.knob.layer.position = CGPointMake(CGRectGetMaxX(frame), CGRectGetMidY(frame));
 	} else {
-		oldKnobWidth = self.knob.frame.size.height;
-		frame = CGRectMake(knobOffset, TUIScrollerKnobInset, knobLength, self.updatedScrollerWidth - TUIScrollerKnobInset);
+		frame = CGRectMake(knobOffset, TUIScrollerKnobInset, knobLength, scrollerWidth - TUIScrollerKnobInset);
 		frame = CGRectInset(frame, 2, 2);
-		
-		self.knob.layer.position = CGPointMake(CGRectGetMidX(frame), CGRectGetMinY(frame));
 	}
 	
 	[self _refreshKnobTimer];
 	
+	// Nothing to do if the knob hasn't moved or changed shape.
+	if (CGRectEqualToRect(frame, _lastKnobFrame) && cornerRadius == _lastKnobCornerRadius)
+		return;
+	_lastKnobFrame = frame;
+	_lastKnobCornerRadius = cornerRadius;
+	
+	if (self.vertical) {
+		oldKnobWidth = self.knob.frame.size.width;
+		self.knob.layer.position = CGPointMake(CGRectGetMaxX(frame), CGRectGetMidY(frame));
+	} else {
+		oldKnobWidth = self.knob.frame.size.height;
+		self.knob.layer.position = CGPointMake(CGRectGetMidX(frame), CGRectGetMinY(frame));
+	}
+	
 	// If the knob width has changed, don't animate it-- it may be a resize.
 	// If we just un-expanded, don't animate the knob shrinking.
 	CGFloat newKnobWidth = (self.vertical ? frame.size.width : frame.size.height);
@@ -240,7 +360,7 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 	BOOL animateKnobChanges = (oldKnobWidth != newKnobWidth && !knobShrinked);
 	[TUIView animateWithDuration:animateKnobChanges ? TUIScrollerFadeSpeed : 0.0f animations:^{
 		self.knob.frame = frame;
-		self.knob.layer.cornerRadius = self.updatedScrollerCornerRadius;
+		self.knob.layer.cornerRadius = cornerRadius;
 	}];
 }
 
@@ -383,7 +503,8 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 		CGPoint p = [self localPointForEvent:event];
 		CGSize diff = CGSizeMake(p.x - _mouseDown.x, p.y - _mouseDown.y);
 		CGFloat proportion = [self adjustedKnobProportionForDifference:diff];
-		CGFloat maxContentOffset = [self adjustedMaximumContentOffet];
+		[self _updateGeometryForVisibleSize:self.scrollView.bounds.size];
+		CGFloat maxContentOffset = _geometry.maximumContentOffset;
 		
 		CGPoint scrollOffset = self.scrollView.contentOffset;
 		if (self.vertical)
@@ -398,61 +519,6 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 	[super mouseDragged:event];
 }
 
-- (CGFloat)adjustedKnobOffsetForWidth:(CGFloat)knobLength {
-	CGRect trackBounds = self.bounds;
-	CGRect visible = self.scrollView.visibleRect;
-	CGSize contentSize = self.scrollView.contentSize;
-	
-	CGFloat rangeOfMotion, maxOffset, currentOffset;
-	if (self.vertical) {
-		rangeOfMotion = trackBounds.size.height - knobLength;
-		maxOffset = contentSize.height - visible.size.height;
-		currentOffset = visible.origin.y;
-	} else {
-		rangeOfMotion = trackBounds.size.width - knobLength;
-		maxOffset = contentSize.width - visible.size.width;
-		currentOffset = visible.origin.x;
-	}
-	
-	CGFloat offsetProportion = 1.0 - (maxOffset - currentOffset) / maxOffset;
-	CGFloat knobOffset = offsetProportion * rangeOfMotion;
-	
-	if (isnan(knobOffset)) {
-		knobOffset = 0.0f;
-	} else if (self.vertical) {
-		if (knobOffset + knobLength > trackBounds.size.height)
-			knobOffset = trackBounds.size.height - knobLength;
-		else if (knobOffset < trackBounds.origin.y)
-			knobOffset = trackBounds.origin.y;
-	} else {
-		if (knobOffset + knobLength > trackBounds.size.width)
-			knobOffset = trackBounds.size.width - knobLength;
-		else if (knobOffset < trackBounds.origin.x)
-			knobOffset = trackBounds.origin.x;
-	}
-	
-	return knobOffset;
-}
-
-- (CGFloat)adjustedKnobWidth {
-	CGRect trackBounds = self.bounds;
-	CGRect visible = self.scrollView.visibleRect;
-	CGSize contentSize = self.scrollView.contentSize;
-	
-	CGFloat knobLength = TUIScrollerMinimumKnobSize;
-	if (self.vertical)
-		knobLength = trackBounds.size.height * (visible.size.height / contentSize.height);
-	else
-		knobLength = trackBounds.size.width * (visible.size.width / contentSize.width);
-	
-	if (knobLength < TUIScrollerMinimumKnobSize)
-		knobLength = TUIScrollerMinimumKnobSize;
-	if (isnan(knobLength))
-		knobLength = 0.0;
-	
-	return knobLength;
-}
-
 - (CGFloat)adjustedKnobProportionForDifference:(CGSize)diff {
 	CGRect trackBounds = self.bounds;
 	
@@ -471,14 +537,4 @@ static NSTimeInterval const TUIScrollerDisplayDuration = 0.75f;
 	return ((knobOffset - 1.0) / maxKnobOffset);
 }
 
-- (CGFloat)adjustedMaximumContentOffet {
-	CGRect visible = self.scrollView.visibleRect;
-	CGSize contentSize = self.scrollView.contentSize;
-	
-	if (self.vertical)
-		return (contentSize.height - visible.size.height);
-	else
-		return (contentSize.width - visible.size.width);
-}
-
 @end
@@ -19,6 +19,9 @@
 
 @class NSFont;
 
+/**
+ These keep no state between calls, so they're safe to use from any thread, for instance to measure many strings at once on background queues. Laid out text is shared through TUITextLayout.
+ */
 @interface NSAttributedString (TUIStringDrawing)
 
 - (CGSize)ab_size;
@@ -21,14 +21,6 @@
 
 @implementation NSAttributedString (TUIStringDrawing)
 
-- (TUITextRenderer *)ab_sharedTextRenderer
-{
-	static TUITextRenderer *t = nil;
-	if(!t)
-		t = [[TUITextRenderer alloc] init];
-	return t;
-}
-
 - (CGSize)ab_sizeConstrainedToWidth:(CGFloat)width
 {
 	return [self ab_sizeConstrainedToSize:CGSizeMake(width, 2000)]; // big enough
@@ -36,7 +28,13 @@
 
 - (CGSize)ab_sizeConstrainedToSize:(CGSize)size
 {
-	TUITextRenderer *t = [self ab_sharedTextRenderer];
+	// when everything fits, the shared layout is what drawing it at this width will use
+	CGSize layoutSize = [TUITextLayout layoutForAttributedString:self width:size.width numberOfLines:0].size;
+	if(layoutSize.height <= size.height)
+		return layoutSize;
+	
+	// measure just the lines that fit
+	TUITextRenderer *t = [[TUITextRenderer alloc] init];
 	t.attributedString = self;
 	t.frame = CGRectMake(0, 0, size.width, size.height);
 	return [t size];
@@ -49,7 +47,7 @@
 
 - (CGSize)ab_drawInRect:(CGRect)rect context:(CGContextRef)ctx
 {
-	TUITextRenderer *t = [self ab_sharedTextRenderer];
+	TUITextRenderer *t = [[TUITextRenderer alloc] init];
 	t.attributedString = self;
 	t.frame = rect;
 	[t drawInContext:ctx];
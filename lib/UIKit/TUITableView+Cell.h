@@ -28,6 +28,7 @@
 -(BOOL)__isDraggingCell;
 -(void)__beginDraggingCell:(TUITableViewCell *)cell offset:(CGPoint)offset location:(CGPoint)location;
 -(void)__updateDraggingCell:(TUITableViewCell *)cell offset:(CGPoint)offset location:(CGPoint)location;
+-(void)__updateDragToReorderTarget;
 -(void)__endDraggingCell:(TUITableViewCell *)cell offset:(CGPoint)offset location:(CGPoint)location;
 
 @end
@@ -16,6 +16,7 @@
 
 #import "TUITableView+Cell.h"
 #import "TUITableViewCell+Private.h"
+#import "TUIScrollView+Private.h"
 
 // Dragged cells should be just above pinned headers
 #define kTUITableViewDraggedCellZPosition 1001
@@ -124,6 +125,49 @@
   // scroll content if necessary (scroll view figures out whether it's necessary or not)
   [self beginContinuousScrollForDragAtPoint:location animated:TRUE];
   
+  // while we're scrolling continuously, both mouse events and scroll ticks move the
+  // dragged cell; only figure out where it would land once per frame, from the tick.
+  if([self _isScrollingContinuously]){
+    _tableFlags.dragToReorderTargetNeedsUpdate = 1;
+  }else{
+    [self __updateDragToReorderTarget];
+  }
+  
+}
+
+/**
+ * @brief Continuous scroll frame callback
+ * 
+ * Recomputes the drag-to-reorder target if the dragged cell has moved since the
+ * last frame.
+ */
+-(void)_continuousScrollDidTick {
+  [super _continuousScrollDidTick];
+  
+  if(_tableFlags.dragToReorderTargetNeedsUpdate && [self __isDraggingCell]){
+    [self __updateDragToReorderTarget];
+  }
+  
+}
+
+/**
+ * @brief Update the index path a dragged cell would be moved to
+ * 
+ * Surrounding cells and section headers are displaced to make room for the
+ * dragged cell at its current location.
+ */
+-(void)__updateDragToReorderTarget {
+  BOOL animate = TRUE;
+  
+  _tableFlags.dragToReorderTargetNeedsUpdate = 0;
+  
+  TUITableViewCell *cell = _dragToReorderCell;
+  if(cell == nil) return;
+  
+  CGRect visible = [self visibleRect];
+  // constraint the location to the viewport
+  CGPoint location = CGPointMake(_currentDragToReorderLocation.x, MAX(0, MIN(visible.size.height, _currentDragToReorderLocation.y)));
+  
   TUITableViewInsertionMethod insertMethod = TUITableViewInsertionMethodAtIndex;
   NSIndexPath *currentPath = nil;
   NSInteger sectionIndex = -1;
@@ -282,6 +326,11 @@
   // cancel our continuous scroll
   [self endContinuousScrollAnimated:TRUE];
   
+  // catch up on the last frame's worth of movement, if any
+  if(_tableFlags.dragToReorderTargetNeedsUpdate && [self __isDraggingCell]){
+    [self __updateDragToReorderTarget];
+  }
+  
   // finalize drag to reorder if we have a drag index
   if(_currentDragToReorderIndexPath != nil){
     NSIndexPath *targetIndexPath;
@@ -358,6 +407,7 @@
   }
   
   _previousDragToReorderIndexPath = nil;
+  _tableFlags.dragToReorderTargetNeedsUpdate = 0;
   
   // and clean up
   _dragToReorderCell = nil;
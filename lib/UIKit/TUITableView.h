@@ -46,6 +46,12 @@ typedef enum {
 
 @optional
 
+// when restoring a scroll position anchor, rows away from the anchor use this height until they are scrolled into view
+- (CGFloat)tableView:(TUITableView *)tableView estimatedHeightForRowAtIndexPath:(NSIndexPath *)indexPath;
+
+// return YES if -tableView:heightForRowAtIndexPath: is safe to call from any thread (for instance if it only measures text with the ab_size methods), rows are then measured in parallel when the table reloads
+- (BOOL)tableViewCanMeasureRowsConcurrently:(TUITableView *)tableView;
+
 - (void)tableView:(TUITableView *)tableView willDisplayCell:(TUITableViewCell *)cell forRowAtIndexPath:(NSIndexPath *)indexPath; // called after the cell's frame has been set but before it's added as a subview
 - (void)tableView:(TUITableView *)tableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath; // happens on left/right mouse down, key up/down
 - (void)tableView:(TUITableView *)tableView didDeselectRowAtIndexPath:(NSIndexPath *)indexPath;
@@ -83,6 +89,7 @@ typedef enum {
 	NSInteger                     _futureMakeFirstResponderToken;
 	NSIndexPath            * _keepVisibleIndexPathForReload;
 	CGFloat                       _relativeOffsetForReload;
+	NSDictionary                * _scrollPositionAnchorForRestore;
 	
 	// drag-to-reorder state
   TUITableViewCell            * _dragToReorderCell;
@@ -102,6 +109,10 @@ typedef enum {
 		unsigned int dataSourceNumberOfSectionsInTableView:1;
 		unsigned int delegateTableViewWillDisplayCellForRowAtIndexPath:1;
 		unsigned int maintainContentOffsetAfterReload:1;
+		unsigned int dragToReorderTargetNeedsUpdate:1;
+		unsigned int delegateEstimatedHeightForRowAtIndexPath:1;
+		unsigned int hasEstimatedRowHeights:1;
+		unsigned int delegateCanMeasureRowsConcurrently:1;
 	} _tableFlags;
 	
 }
@@ -121,6 +132,16 @@ typedef enum {
  */
 - (void)reloadDataMaintainingVisibleIndexPath:(NSIndexPath *)indexPath relativeOffset:(CGFloat)relativeOffset;
 
+/**
+ Describes the current scroll position as the identifier of the top visible row (see -tableView:identifierForRowAtIndexPath:) and its offset from the top of the visible area. The result is a property list suitable for saving across launches; nil if there's no visible row or the data source doesn't provide row identifiers.
+ */
+- (NSDictionary *)scrollPositionAnchor;
+
+/**
+ Scrolls back to a position returned by -scrollPositionAnchor when the table is next laid out. Use it instead of reloading and then scrolling to a row. If the delegate provides estimated row heights, only the rows that end up visible are measured; the rest are measured as they scroll into view.
+ */
+- (void)restoreScrollPositionAnchor:(NSDictionary *)anchor;
+
 // Forces a re-calculation and re-layout of the table. This is most useful for animating the relayout. It is potentially _more_ expensive than -reloadData since it has to allow for animating.
 - (void)reloadLayout;
 
@@ -188,6 +209,10 @@ typedef enum {
 
 - (TUIView *)tableView:(TUITableView *)tableView headerViewForSection:(NSInteger)section;
 
+// the following are required to save and restore scroll position anchors; identifiers should be stable across launches
+- (NSString *)tableView:(TUITableView *)tableView identifierForRowAtIndexPath:(NSIndexPath *)indexPath;
+- (NSIndexPath *)tableView:(TUITableView *)tableView indexPathForRowWithIdentifier:(NSString *)identifier;
+
 // the following are required to support row reordering
 - (BOOL)tableView:(TUITableView *)tableView canMoveRowAtIndexPath:(NSIndexPath *)indexPath;
 - (void)tableView:(TUITableView *)tableView moveRowAtIndexPath:(NSIndexPath *)fromIndexPath toIndexPath:(NSIndexPath *)toIndexPath;
@@ -23,9 +23,13 @@
 // header views need to be above the cells at all times
 #define HEADER_Z_POSITION 1000 
 
+static NSString * const TUITableViewScrollPositionAnchorIdentifierKey = @"identifier";
+static NSString * const TUITableViewScrollPositionAnchorRelativeOffsetKey = @"relativeOffset";
+
 typedef struct {
 	CGFloat offset; // from beginning of section
 	CGFloat height;
+	BOOL estimated; // height came from the delegate's estimate, not yet measured
 } TUITableViewRowInfo;
 
 @interface TUITableViewSection : NSObject
@@ -37,6 +41,7 @@ typedef struct {
 	CGFloat               sectionHeight;
 	CGFloat               sectionOffset;
 	TUITableViewRowInfo  *rowInfo;
+	NSUInteger            numberOfEstimatedRows;
 }
 
 @property (strong, readonly) TUIView           *headerView;
@@ -72,21 +77,108 @@ typedef struct {
 }
 
 - (void)_setupRowHeights
+{
+	[self _setupRowHeightsMeasuringFromRow:0 budget:CGFLOAT_MAX concurrently:NO];
+}
+
+/**
+ * @brief Set up row heights, measuring only some of the rows
+ * 
+ * Rows before @p firstMeasuredRow, and rows after @p budget points of rows
+ * have been measured, use the delegate's estimated height instead. When
+ * every row is measured and @p concurrently is set, rows are measured in
+ * parallel on the global queue.
+ * 
+ * @return the remaining measurement budget
+ */
+- (CGFloat)_setupRowHeightsMeasuringFromRow:(NSInteger)firstMeasuredRow budget:(CGFloat)budget concurrently:(BOOL)concurrently
 {
 	sectionHeight = 0.0;
+	numberOfEstimatedRows = 0;
 	
 	TUIView *header;
 	if((header = self.headerView) != nil) {
 		sectionHeight += roundf(header.frame.size.height);
 	}
+	
+	if(concurrently && firstMeasuredRow <= 0 && budget == CGFLOAT_MAX) {
+		// heights don't depend on each other, only the offsets do
+		TUITableView *tableView = _tableView;
+		TUITableViewRowInfo *info = rowInfo;
+		NSInteger section = sectionIndex;
+		NSUInteger rows = numberOfRows;
+		size_t stride = 32;
+		dispatch_apply((rows + stride - 1) / stride, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t chunk) {
+			@autoreleasepool {
+				for(NSUInteger i = chunk * stride; i < MIN(rows, (chunk + 1) * stride); ++i) {
+					info[i].height = roundf([tableView.delegate tableView:tableView heightForRowAtIndexPath:[NSIndexPath indexPathForRow:i inSection:section]]);
+				}
+			}
+		});
+		for(NSUInteger i = 0; i < numberOfRows; ++i) {
+			rowInfo[i].offset = sectionHeight;
+			rowInfo[i].estimated = NO;
+			sectionHeight += rowInfo[i].height;
+		}
+		return budget;
+	}
   
 	for(int i = 0; i < numberOfRows; ++i) {
-		CGFloat h = roundf([_tableView.delegate tableView:_tableView heightForRowAtIndexPath:[NSIndexPath indexPathForRow:i inSection:sectionIndex]]);
+		NSIndexPath *indexPath = [NSIndexPath indexPathForRow:i inSection:sectionIndex];
+		BOOL estimated = (i < firstMeasuredRow || budget <= 0.0);
+		CGFloat h;
+		if(estimated) {
+			h = roundf([_tableView.delegate tableView:_tableView estimatedHeightForRowAtIndexPath:indexPath]);
+			numberOfEstimatedRows++;
+		} else {
+			h = roundf([_tableView.delegate tableView:_tableView heightForRowAtIndexPath:indexPath]);
+			budget -= h;
+		}
 		rowInfo[i].offset = sectionHeight;
 		rowInfo[i].height = h;
+		rowInfo[i].estimated = estimated;
 		sectionHeight += h;
 	}
 	
+	return budget;
+}
+
+- (NSUInteger)numberOfEstimatedRows
+{
+	return numberOfEstimatedRows;
+}
+
+- (BOOL)rowHeightIsEstimated:(NSInteger)i
+{
+	return (i >= 0 && i < numberOfRows) ? rowInfo[i].estimated : NO;
+}
+
+/**
+ * @brief Replace a row's estimated height with its real height
+ * 
+ * The following rows in the section are shifted by the difference.
+ * 
+ * @return the change in the section height
+ */
+- (CGFloat)_measureEstimatedRow:(NSInteger)i
+{
+	if(![self rowHeightIsEstimated:i])
+		return 0.0;
+	
+	CGFloat h = roundf([_tableView.delegate tableView:_tableView heightForRowAtIndexPath:[NSIndexPath indexPathForRow:i inSection:sectionIndex]]);
+	CGFloat delta = h - rowInfo[i].height;
+	rowInfo[i].height = h;
+	rowInfo[i].estimated = NO;
+	numberOfEstimatedRows--;
+	
+	if(delta != 0.0) {
+		for(NSUInteger j = i + 1; j < numberOfRows; ++j) {
+			rowInfo[j].offset += delta;
+		}
+		sectionHeight += delta;
+	}
+	
+	return delta;
 }
 
 - (CGFloat)rowHeight:(NSInteger)i
@@ -144,6 +236,8 @@ typedef struct {
 
 @interface TUITableView (Private)
 - (void)_updateSectionInfo;
+- (void)_updateSectionInfoEstimatingRowsAwayFromIndexPath:(NSIndexPath *)anchorIndexPath;
+- (BOOL)_measureEstimatedRowsInVisibleRect;
 - (void)_updateDerepeaterViews;
 @end
 
@@ -177,6 +271,8 @@ typedef struct {
 - (void)setDelegate:(id<TUITableViewDelegate>)d
 {
 	_tableFlags.delegateTableViewWillDisplayCellForRowAtIndexPath = [d respondsToSelector:@selector(tableView:willDisplayCell:forRowAtIndexPath:)];
+	_tableFlags.delegateEstimatedHeightForRowAtIndexPath = [d respondsToSelector:@selector(tableView:estimatedHeightForRowAtIndexPath:)];
+	_tableFlags.delegateCanMeasureRowsConcurrently = [d respondsToSelector:@selector(tableViewCanMeasureRowsConcurrently:)];
 	[super setDelegate:d]; // must call super
 }
 
@@ -254,6 +350,21 @@ typedef struct {
  * The previous section info is released and new section info is created.
  */
 - (void)_updateSectionInfo {
+  [self _updateSectionInfoEstimatingRowsAwayFromIndexPath:nil];
+}
+
+/**
+ * @brief Update section info, measuring only the rows around an index path
+ * 
+ * If @p anchorIndexPath is not nil and the delegate provides estimated row
+ * heights, only the rows from @p anchorIndexPath down through one screenful
+ * are measured; the others are estimated until they become visible.
+ */
+- (void)_updateSectionInfoEstimatingRowsAwayFromIndexPath:(NSIndexPath *)anchorIndexPath {
+  
+  if(!_tableFlags.delegateEstimatedHeightForRowAtIndexPath){
+    anchorIndexPath = nil;
+  }
   
   if(_sectionInfo != nil){
     
@@ -278,10 +389,21 @@ typedef struct {
 	
 	NSMutableArray *sections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
 	
+	_tableFlags.hasEstimatedRowHeights = 0;
+	CGFloat budget = (anchorIndexPath != nil) ? self.bounds.size.height : CGFLOAT_MAX;
+	BOOL concurrently = _tableFlags.delegateCanMeasureRowsConcurrently && [self.delegate tableViewCanMeasureRowsConcurrently:self];
+	
 	CGFloat offset = [self.headerView bounds].size.height - self.contentInset.top*2;
 	for(int s = 0; s < numberOfSections; ++s) {
 		TUITableViewSection *section = [[TUITableViewSection alloc] initWithNumberOfRows:[_dataSource tableView:self numberOfRowsInSection:s] sectionIndex:s tableView:self];
-		[section _setupRowHeights];
+		NSInteger firstMeasuredRow = 0;
+		if(anchorIndexPath != nil && s <= anchorIndexPath.section) {
+			firstMeasuredRow = (s == anchorIndexPath.section) ? anchorIndexPath.row : NSIntegerMax;
+		}
+		budget = [section _setupRowHeightsMeasuringFromRow:firstMeasuredRow budget:budget concurrently:concurrently];
+		if([section numberOfEstimatedRows] > 0) {
+			_tableFlags.hasEstimatedRowHeights = 1;
+		}
 		section.sectionOffset = offset;
 		offset += [section sectionHeight];
 		[sections addObject:section];
@@ -292,6 +414,68 @@ typedef struct {
 	
 }
 
+/**
+ * @brief Measure any rows with estimated heights that have become visible
+ * 
+ * The top visible row is kept in place on screen while the rows around it
+ * change height.
+ * 
+ * @return whether any row heights changed
+ */
+- (BOOL)_measureEstimatedRowsInVisibleRect {
+  if(!_tableFlags.hasEstimatedRowHeights) return NO;
+  
+  BOOL changed = NO;
+  BOOL measuredAny = YES;
+  
+  // measuring can bring more estimated rows into view, so repeat until it doesn't
+  while(measuredAny) {
+    measuredAny = NO;
+    
+    NSArray *indexPaths = [self indexPathsForRowsInRect:[self visibleRect]];
+    if([indexPaths count] == 0) break;
+    
+    NSIndexPath *topIndexPath = [indexPaths objectAtIndex:0];
+    CGFloat topBefore = CGRectGetMaxY([self rectForRowAtIndexPath:topIndexPath]);
+    
+    for(NSIndexPath *indexPath in indexPaths) {
+      TUITableViewSection *section = [_sectionInfo objectAtIndex:indexPath.section];
+      if(![section rowHeightIsEstimated:indexPath.row]) continue;
+      
+      CGFloat delta = [section _measureEstimatedRow:indexPath.row];
+      if(delta != 0.0) {
+        for(NSInteger s = indexPath.section + 1; s < [_sectionInfo count]; ++s) {
+          TUITableViewSection *following = [_sectionInfo objectAtIndex:s];
+          following.sectionOffset += delta;
+        }
+        _contentHeight += delta;
+        changed = YES;
+      }
+      measuredAny = YES;
+    }
+    
+    if(changed) {
+      self.contentSize = CGSizeMake(self.bounds.size.width, _contentHeight);
+      // rows above a resized row move in our (bottom-up) coordinates; follow the top row
+      CGFloat shift = CGRectGetMaxY([self rectForRowAtIndexPath:topIndexPath]) - topBefore;
+      if(shift != 0.0) {
+        [self setContentOffset:CGPointMake(_unroundedContentOffset.x, _unroundedContentOffset.y - shift)];
+      }
+    }
+  }
+  
+  BOOL hasEstimatedRowHeights = NO;
+  for(TUITableViewSection *section in _sectionInfo) {
+    if([section numberOfEstimatedRows] > 0) {
+      hasEstimatedRowHeights = YES;
+      break;
+    }
+  }
+  _tableFlags.hasEstimatedRowHeights = hasEstimatedRowHeights;
+  
+  return changed;
+}
+
 - (void)_enqueueReusableCell:(TUITableViewCell *)cell
 {
 	NSString *identifier = cell.reuseIdentifier;
@@ -659,19 +843,32 @@ static NSInteger SortCells(TUITableViewCell *a, TUITableViewCell *b, void *ctx)
 {
 	CGRect bounds = self.bounds;
 
-	if(!_sectionInfo || !CGSizeEqualToSize(bounds.size, _lastSize)) {
+	if(!_sectionInfo || !CGSizeEqualToSize(bounds.size, _lastSize) || _scrollPositionAnchorForRestore) {
 	  
 		// save scroll position
 		CGFloat previousOffset = 0.0f;
 		NSIndexPath *savedIndexPath = nil;
 		CGFloat relativeOffset = 0.0;
+		NSIndexPath *restoredIndexPath = nil;
 		
 		CGFloat resizingOffset = 0.0;
 		if ([self.nsView inLiveResize]) {
 			resizingOffset = (_lastSize.height - bounds.size.height);
 		}
 		
-		if(_tableFlags.maintainContentOffsetAfterReload) {
+		if(_scrollPositionAnchorForRestore) {
+			NSString *identifier = [_scrollPositionAnchorForRestore objectForKey:TUITableViewScrollPositionAnchorIdentifierKey];
+			if(identifier != nil && [_dataSource respondsToSelector:@selector(tableView:indexPathForRowWithIdentifier:)]) {
+				restoredIndexPath = [_dataSource tableView:self indexPathForRowWithIdentifier:identifier];
+				relativeOffset = [[_scrollPositionAnchorForRestore objectForKey:TUITableViewScrollPositionAnchorRelativeOffsetKey] floatValue];
+			}
+			_scrollPositionAnchorForRestore = nil;
+			_keepVisibleIndexPathForReload = nil;
+		}
+		
+		if(restoredIndexPath) {
+			// restoring takes precedence over any other saved position
+		} else if(_tableFlags.maintainContentOffsetAfterReload) {
 			previousOffset = self.contentSize.height + self.contentOffset.y;
 		} else {
 			if(_tableFlags.forceSaveScrollPosition || resizingOffset) {
@@ -691,7 +888,7 @@ static NSInteger SortCells(TUITableViewCell *a, TUITableViewCell *b, void *ctx)
 			}
 		}
 		
-		[self _updateSectionInfo]; // clean up any previous section info and recreate it
+		[self _updateSectionInfoEstimatingRowsAwayFromIndexPath:restoredIndexPath]; // clean up any previous section info and recreate it
 		self.contentSize = CGSizeMake(self.bounds.size.width, _contentHeight);
 		
 		_lastSize = bounds.size;
@@ -701,8 +898,16 @@ static NSInteger SortCells(TUITableViewCell *a, TUITableViewCell *b, void *ctx)
 			[self scrollToTopAnimated:NO];
 		}
 		
+		if(restoredIndexPath != nil && (restoredIndexPath.section >= [_sectionInfo count] || restoredIndexPath.row >= [self numberOfRowsInSection:restoredIndexPath.section])) {
+			restoredIndexPath = nil; // the data source handed back a row we don't have
+		}
+		
 		// restore scroll position
-		if(_tableFlags.maintainContentOffsetAfterReload) {
+		if(restoredIndexPath) {
+			CGRect v = [self visibleRect];
+			CGRect r = [self rectForRowAtIndexPath:restoredIndexPath];
+			self.contentOffset = CGPointMake(self.contentOffset.x, -(CGRectGetMaxY(r) + relativeOffset - v.size.height));
+		} else if(_tableFlags.maintainContentOffsetAfterReload) {
 			CGFloat newOffset = previousOffset - self.contentSize.height - resizingOffset;
 			self.contentOffset = CGPointMake(self.contentOffset.x, newOffset);
 		} else {
@@ -932,6 +1137,35 @@ static NSInteger SortCells(TUITableViewCell *a, TUITableViewCell *b, void *ctx)
 	return NO;
 }
 
+- (NSDictionary *)scrollPositionAnchor
+{
+	if(![_dataSource respondsToSelector:@selector(tableView:identifierForRowAtIndexPath:)])
+		return nil;
+	
+	NSIndexPath *topIndexPath = [self _topVisibleIndexPath];
+	if(topIndexPath == nil)
+		return nil;
+	
+	NSString *identifier = [_dataSource tableView:self identifierForRowAtIndexPath:topIndexPath];
+	if(identifier == nil)
+		return nil;
+	
+	CGRect v = [self visibleRect];
+	CGRect r = [self rectForRowAtIndexPath:topIndexPath];
+	CGFloat relativeOffset = ((v.origin.y + v.size.height) - (r.origin.y + r.size.height));
+	
+	return @{
+		TUITableViewScrollPositionAnchorIdentifierKey: identifier,
+		TUITableViewScrollPositionAnchorRelativeOffsetKey: @(relativeOffset),
+	};
+}
+
+- (void)restoreScrollPositionAnchor:(NSDictionary *)anchor
+{
+	_scrollPositionAnchorForRestore = [anchor copy];
+	[self setNeedsLayout];
+}
+
 - (void)reloadDataMaintainingVisibleIndexPath:(NSIndexPath *)indexPath relativeOffset:(CGFloat)relativeOffset
 {
 	_keepVisibleIndexPathForReload = indexPath;
@@ -996,6 +1230,8 @@ static NSInteger SortCells(TUITableViewCell *a, TUITableViewCell *b, void *ctx)
 			
 			BOOL visibleCellsNeedRelayout = [self _preLayoutCells];
 			[super layoutSubviews]; // this will munge with the contentOffset
+			if([self _measureEstimatedRowsInVisibleRect])
+				visibleCellsNeedRelayout = YES;
 			[self _layoutSectionHeaders:visibleCellsNeedRelayout];
 			[self _layoutCells:visibleCellsNeedRelayout];
 			
@@ -1017,6 +1253,7 @@ static NSInteger SortCells(TUITableViewCell *a, TUITableViewCell *b, void *ctx)
 	
 	[self _preLayoutCells];
 	[super layoutSubviews]; // this will munge with the contentOffset
+	[self _measureEstimatedRowsInVisibleRect];
 	[self _layoutSectionHeaders:YES];
 	[self _layoutCells:YES];
 }
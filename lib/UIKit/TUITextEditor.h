@@ -20,6 +20,7 @@
 {
 	NSTextInputContext *inputContext;
 	NSMutableAttributedString *backingStore;
+	NSMutableAttributedString *secureString; // bullets for backingStore while secure, edited along with it
 	NSRange markedRange;
 	NSDictionary *defaultAttributes;
 	NSDictionary *markedAttributes;
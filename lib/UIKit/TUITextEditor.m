@@ -19,6 +19,11 @@
 #import "TUINSWindow.h"
 #import "TUITextRenderer+Private.h"
 
+static NSString *TUITextEditorBullets(NSUInteger length)
+{
+	return [@"" stringByPaddingToLength:length withString:@"\u2022" startingAtIndex:0];
+}
+
 @implementation TUITextEditor
 
 @synthesize defaultAttributes;
@@ -35,6 +40,8 @@
 		inputContext.acceptsGlyphInfo = YES;
 		
 		_secure = NO;
+		_flags.layoutsByParagraph = 1;
+		_flags.bypassesLayoutCache = 1;
 		self.attributedString = backingStore;
 	}
 	return self;
@@ -46,20 +53,22 @@
 	}
 	
 	_secure = secured;
+	secureString = nil;
 	[self _resetFramesetter];
 }
 
+- (void)setDefaultAttributes:(NSDictionary *)attributes
+{
+	defaultAttributes = attributes;
+	secureString = nil; // bullets take the default attributes
+}
+
 - (NSAttributedString*)drawingAttributedString {
 	if(_secure) {
-		NSString *placeholder = @"\u2022";
-		NSUInteger backingStoreLength = backingStore.length;
-		NSMutableString *string = [NSMutableString string];
-		for(int i = 0; i < backingStoreLength; i++) {
-			[string appendString:placeholder];
-		}
-		
-		NSAttributedString *securePlaceHolder = [[NSAttributedString alloc] initWithString:string attributes:defaultAttributes];
-		return securePlaceHolder;
+		// kept in step by -_textDidChangeInRange:changeInLength:, rebuilt if the backing store was changed some other way
+		if(!secureString || [secureString length] != [backingStore length])
+			secureString = [[NSMutableAttributedString alloc] initWithString:TUITextEditorBullets([backingStore length]) attributes:defaultAttributes];
+		return secureString;
 	}
 	
 	return [super drawingAttributedString];
@@ -96,12 +105,30 @@
 
 - (void)_textDidChange
 {
+	secureString = nil; // no telling what changed
 	[inputContext invalidateCharacterCoordinates];
 	[self reset];
 	[view setNeedsDisplay];
 	[view performSelector:@selector(_textDidChange)];
 }
 
+// only the paragraphs around range are laid out again
+- (void)_textDidChangeInRange:(NSRange)range changeInLength:(NSInteger)delta
+{
+	if((NSInteger)[secureString length] == (NSInteger)[backingStore length] - delta && [secureString length] > 0) {
+		// new bullets pick up the attributes of the ones beside them
+		NSRange oldRange = NSMakeRange(range.location, range.length - delta);
+		[secureString replaceCharactersInRange:oldRange withString:TUITextEditorBullets(range.length)];
+	} else {
+		secureString = nil; // out of step already, rebuilt when it's next drawn
+	}
+	
+	[inputContext invalidateCharacterCoordinates];
+	[self _attributedStringDidChangeInRange:range changeInLength:delta];
+	[view setNeedsDisplay];
+	[view performSelector:@selector(_textDidChange)];
+}
+
 - (NSString *)text
 {
 	return [backingStore string];
@@ -218,7 +245,7 @@
 	selectedRange.location = range.location;
 	selectedRange.length = 0;
 	self.selectedRange = selectedRange;
-	[self _textDidChange];
+	[self _textDidChangeInRange:NSMakeRange(range.location, 0) changeInLength:-(NSInteger)range.length];
 	[self _scrollToIndex:MAX(_selectionStart, _selectionEnd)];
 }
 
@@ -279,7 +306,7 @@
 	selectedRange.length = 0;
 	[self unmarkText];
 	self.selectedRange = selectedRange;
-	[self _textDidChange];
+	[self _textDidChangeInRange:NSMakeRange(replacementRange.location, [aString length]) changeInLength:(NSInteger)[aString length] - (NSInteger)replacementRange.length];
 	[self _scrollToIndex:MAX(_selectionStart, _selectionEnd)];
 }
 
@@ -322,7 +349,7 @@
 	selectedRange.location = replacementRange.location + newSelection.location; // Just for now, only select the marked text
 	selectedRange.length = newSelection.length;
 	self.selectedRange = selectedRange;
-	[self _textDidChange];
+	[self _textDidChangeInRange:NSMakeRange(replacementRange.location, [aString length]) changeInLength:(NSInteger)[aString length] - (NSInteger)replacementRange.length];
 }
 
 /* The receiver unmarks the marked text. If no marked text, the invocation of this
@@ -8,10 +8,20 @@
 
 #import "TUITextRenderer+Accessibility.h"
 #import "TUIView.h"
+#import "TUILabel.h"
 
 
 @implementation TUITextRenderer (Accessibility)
 
+// Labels only make their attributed string when they need it to draw, and
+// plain one line labels don't, so ask the label rather than wait for a draw.
+- (NSString *)_accessibilityString
+{
+	if(self.attributedString == nil && [self.view isKindOfClass:[TUILabel class]])
+		return [[(TUILabel *)self.view attributedString] string];
+	return [self.attributedString string];
+}
+
 
 #pragma mark NSAccessibility
 
@@ -67,11 +77,11 @@
     } else if([attribute isEqualToString:NSAccessibilityChildrenAttribute]) {
 		return [NSArray array];
 	} else if([attribute isEqualToString:NSAccessibilityDescriptionAttribute]) {
-		return [self.attributedString string];
+		return [self _accessibilityString];
 	} else if([attribute isEqualToString:NSAccessibilityValueAttribute]) {
-		return [self.attributedString string];
+		return [self _accessibilityString];
 	} else if([attribute isEqualToString:NSAccessibilityTitleAttribute]) {
-		return [self.attributedString string];
+		return [self _accessibilityString];
 	} else if([attribute isEqualToString:NSAccessibilityEnabledAttribute]) {
 		return [NSNumber numberWithBool:YES];
 	}else {
@@ -22,6 +22,8 @@
 - (CFIndex)stringIndexForEvent:(NSEvent *)event;
 - (void)resetSelection;
 - (CGRect)rectForCurrentSelection;
+- (CGRect)rectForRange:(CFRange)range;
+- (id<ABActiveTextRange>)rangeInRanges:(NSArray *)ranges forStringIndex:(CFIndex)index;
 
 - (void)copy:(id)sender;
 
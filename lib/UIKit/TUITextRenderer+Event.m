@@ -60,7 +60,14 @@
 
 - (CFIndex)stringIndexForPoint:(CGPoint)p
 {
-	return AB_CTFrameGetStringIndexForPosition([self ctFrame], p);
+	if([self _usesParagraphLayouts])
+		return [self _paragraphStringIndexForPoint:p];
+	
+	// p is relative to our frame, line origins are relative to the frame's path
+	AB_CTLineTable *lines = [self _lineTable];
+	p.x += frame.origin.x - _ct_offset.x - lines->bounds.origin.x;
+	p.y += frame.origin.y - _ct_offset.y - lines->bounds.origin.y;
+	return AB_CTLineTableGetStringIndexForPosition(lines, p);
 }
 
 - (CFIndex)stringIndexForEvent:(NSEvent *)event
@@ -145,12 +152,7 @@
 	}
 	
 	CFIndex eventIndex = [self stringIndexForEvent:event];
-	NSArray *ranges = nil;
-	if(_flags.delegateActiveRangesForTextRenderer) {
-		ranges = [delegate activeRangesForTextRenderer:self];
-	}
-	
-	id<ABActiveTextRange> hitActiveRange = [self rangeInRanges:ranges forStringIndex:eventIndex];
+	id<ABActiveTextRange> hitActiveRange = [self _activeRangeForStringIndex:eventIndex];
 	
 	if([event clickCount] > 1)
 		goto normal; // we want double-click-drag-select-by-word, not drag selected text
@@ -243,12 +245,11 @@ normal:
 }
 
 - (CGRect)rectForRange:(CFRange)range {
-	CTFrameRef textFrame = [self ctFrame];
 	CGRect totalRect = CGRectNull;
 	if(range.length > 0) {
 		CFIndex rectCount = 100;
 		CGRect rects[rectCount];
-		AB_CTFrameGetRectsForRangeWithAggregationType(textFrame, range, AB_CTLineRectAggregationTypeBlock, rects, &rectCount);
+		[self _getRects:rects count:&rectCount forCharacterRange:range aggregationType:AB_CTLineRectAggregationTypeBlock];
 		
 		for(CFIndex i = 0; i < rectCount; ++i) {
 			CGRect rect = rects[i];
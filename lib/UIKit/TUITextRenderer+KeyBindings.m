@@ -86,7 +86,7 @@ static NSAttributedString *killBuffer = nil;
 		CFRange r = CFRangeMake(index, 0);
 		CFIndex nRects = 1;
 		CGRect rects[nRects];
-		AB_CTFrameGetRectsForRange([self ctFrame], r, rects, &nRects);
+		[self _getRects:rects count:&nRects forCharacterRange:r aggregationType:AB_CTLineRectAggregationTypeInline];
 		
 		if (nRects == 1) {
 			// If it exists, then scroll to the beginning of the rects.
@@ -104,11 +104,11 @@ static NSAttributedString *killBuffer = nil;
 							by:(CFIndex)incr {
 	CFIndex lineIndex;
 	float xPosition;
-	AB_CTFrameGetLinePositionOfIndex(TEXT, [self ctFrame], index, &lineIndex, &xPosition);
+	AB_CTLineTable *lines = [self _lineTable];
+	AB_CTLineTableGetLinePositionOfIndex(lines, index, &lineIndex, &xPosition);
 	
 	if(lineIndex >= 0) {
-		NSArray *lines = (__bridge NSArray *)CTFrameGetLines([self ctFrame]);
-		CFIndex linesCount = [lines count];
+		CFIndex linesCount = lines->lineCount;
 		
 		// If the incremental value is less than 0 and the line index
 		// is 0, the index doesn't change.
@@ -123,9 +123,7 @@ static NSAttributedString *killBuffer = nil;
 			// If the line index is within text bounds after increment,
 			// return the real character index.
 		} else if(lineIndex + incr >= 0) {
-			CFIndex index;
-			AB_CTFrameGetIndexForPositionInLine(TEXT, [self ctFrame], lineIndex + incr, xPosition, &index);
-			return index;
+			return CTLineGetStringIndexForPosition(lines->lines[lineIndex + incr].line, CGPointMake(xPosition, 0));
 		}
 	}
 	
@@ -5,9 +5,29 @@
 - (CTFramesetterRef)ctFramesetter;
 - (CTFrameRef)ctFrame;
 - (CGPathRef)ctPath;
+- (AB_CTLineTable *)_lineTable; // of ctFrame, owned by the renderer until the frame changes
 - (CFRange)_selectedRange;
 - (void)_resetFramesetter;
 
+// rects for range in our coordinates, use this rather than asking ctFrame directly
+- (void)_getRects:(CGRect *)rects count:(CFIndex *)rectCount forCharacterRange:(CFRange)range aggregationType:(AB_CTLineRectAggregationType)aggregationType;
+// same, remembered until the frame changes; for ranges that are asked for on every draw
+- (void)_getCachedRects:(CGRect *)rects count:(CFIndex *)rectCount forCharacterRange:(CFRange)range aggregationType:(AB_CTLineRectAggregationType)aggregationType;
+
+// Renderers with layoutsByParagraph set lay out each paragraph on its own, so
+// an edit only lays out again the paragraphs it touched. Drawing, rects, hit
+// testing and size go through the paragraphs, text that doesn't fit the frame
+// is clipped; ctFrame still lays out everything, for line navigation.
+- (BOOL)_usesParagraphLayouts;
+- (NSArray *)_paragraphRanges; // NSValues, in order, once the paragraphs are split
+- (CFIndex)_paragraphStringIndexForPoint:(CGPoint)p; // p relative to frame
+- (void)_attributedStringDidChangeInRange:(NSRange)range changeInLength:(NSInteger)delta; // range of the new characters
+
+// activeRanges when set, otherwise the delegate's
+- (id<ABActiveTextRange>)_activeRangeForStringIndex:(CFIndex)index;
+// called by the view as the mouse moves over it, with nil when it leaves the renderer
+- (void)_updateHoveredActiveRangeWithEvent:(NSEvent *)event;
+
 @end
 
 @interface TUITextRenderer (KeyBindings)
@@ -33,13 +33,82 @@ typedef enum {
 
 typedef enum {
 	TUITextVerticalAlignmentTop = 0,
-	// Note that TUITextVerticalAlignmentMiddle and TUITextVerticalAlignmentBottom both have a performance hit because they have to create the CTFrame twice: once to find its height and then again to shift it to match the alignment and height.
-	// Also note that text selection doesn't work properly with anything but TUITextVerticalAlignmentTop.
+	// Middle and Bottom move the laid out lines down within the frame, they cost the same as Top and selection works the same in all of them.
 	TUITextVerticalAlignmentMiddle,
 	TUITextVerticalAlignmentBottom,
 } TUITextVerticalAlignment;
 
 @protocol TUITextRendererDelegate;
+struct TUITextRectCache;
+struct TUIActiveRangeIndexEntry;
+
+// Metrics of one line of a TUITextLayout, origins are in the layout's coordinates.
+typedef AB_CTLineMetrics TUITextLayoutLine;
+
+/**
+ An immutable, laid out attributed string. Layouts are shared process-wide and looked up by string, width and line limit, so text that's measured and then drawn at the same width only gets laid out once.
+ 
+ Layouts are as tall as their text needs, with the top of the first line at the top of a rect of `TUITextLayoutUnconstrainedHeight` points whose origin is at zero. Everything here is safe to use from any thread.
+ */
+@interface TUITextLayout : NSObject {
+	NSAttributedString *_attributedString;
+	CGFloat _width;
+	NSUInteger _numberOfLines;
+	CTFrameRef _ct_frame;
+	CGSize _size;
+	AB_CTLineTable *_lineTable;
+}
+
++ (TUITextLayout *)layoutForAttributedString:(NSAttributedString *)attributedString width:(CGFloat)width numberOfLines:(NSUInteger)numberOfLines; // numberOfLines = 0 for no limit
+
+/**
+ Limits the memory used by cached layouts. The least recently used are dropped first. Defaults to 8MB.
+ */
++ (void)setCacheByteLimit:(NSUInteger)limit;
++ (NSUInteger)cacheHitCount;
++ (NSUInteger)cacheMissCount;
+
+@property (nonatomic, readonly) NSAttributedString *attributedString;
+@property (nonatomic, readonly) CGFloat width;
+@property (nonatomic, readonly) NSUInteger numberOfLines;
+@property (nonatomic, readonly) CTFrameRef ctFrame;
+@property (nonatomic, readonly) CGSize size;
+@property (nonatomic, readonly) CFIndex lineCount;
+@property (nonatomic, readonly) const TUITextLayoutLine *lines;
+@property (nonatomic, readonly) AB_CTLineTable *lineTable; // for looking lines up by position or string index, lives as long as the layout
+
+@end
+
+extern CGFloat const TUITextLayoutUnconstrainedHeight;
+
+/**
+ One line of text in a single font, color and kerning, shaped once and shared process-wide. Short strings that are drawn over and over, like label and button titles or badges, can be drawn from one of these without an attributed string, a framesetter or a frame. Everything here is safe to use from any thread.
+ */
+@interface TUITextLine : NSObject {
+	CTLineRef _ct_line;
+	CGFloat _width;
+	CGFloat _ascent;
+	CGFloat _descent;
+	CGFloat _leading;
+}
+
++ (TUITextLine *)lineForString:(NSString *)string font:(NSFont *)font color:(NSColor *)color kerning:(CGFloat)kerning; // nil font or color and 0 kerning for Core Text's defaults
+
+/**
+ Limits the number of cached lines. The least recently used are dropped first. Defaults to 512.
+ */
++ (void)setCacheCountLimit:(NSUInteger)limit;
++ (NSUInteger)cacheHitCount;
++ (NSUInteger)cacheMissCount;
+
+@property (nonatomic, readonly) CTLineRef ctLine;
+@property (nonatomic, readonly) CGFloat width;
+@property (nonatomic, readonly) CGFloat ascent;
+@property (nonatomic, readonly) CGFloat descent;
+@property (nonatomic, readonly) CGFloat leading;
+
+- (void)drawAtPoint:(CGPoint)point inContext:(CGContextRef)context; // point is the left end of the baseline
+@end
 
 @interface TUITextRenderer : TUIResponder {
 	NSAttributedString *attributedString;
@@ -49,6 +118,12 @@ typedef enum {
 	CTFramesetterRef _ct_framesetter;
 	CGPathRef _ct_path;
 	CTFrameRef _ct_frame;
+	TUITextLayout *_layout; // shared layout _ct_frame comes from, when the text fits in frame
+	CGPoint _ct_offset; // from _ct_frame's coordinates to ours
+	AB_CTLineTable *_ct_lines; // of _ct_frame when it isn't the layout's
+	NSMutableArray *_paragraphs; // see _usesParagraphLayouts
+	CGFloat _paragraphsWidth;
+	CGSize _paragraphsSize;
 	
 	CFIndex _selectionStart;
 	CFIndex _selectionEnd;
@@ -56,12 +131,15 @@ typedef enum {
 	
 	__unsafe_unretained id<TUITextRendererDelegate> delegate;
 	id<ABActiveTextRange> hitRange;
+	NSArray *_activeRanges;
+	struct TUIActiveRangeIndexEntry *_activeRangeIndex; // _activeRanges sorted by location
+	id<ABActiveTextRange> _hoveredActiveRange;
 	
 	CGSize shadowOffset;
 	CGFloat shadowBlur;
 	NSColor *shadowColor;
 	
-	NSMutableDictionary *lineRects;
+	struct TUITextRectCache *_rectCache; // rects of ranges asked for since the frame was laid out
 	
 	TUITextVerticalAlignment verticalAlignment;
 	
@@ -69,6 +147,9 @@ typedef enum {
 		unsigned int drawMaskDragSelection:1;
 		unsigned int backgroundDrawingEnabled:1;
 		unsigned int preDrawBlocksEnabled:1;
+		unsigned int layoutsByParagraph:1;
+		unsigned int bypassesLayoutCache:1;
+		unsigned int paragraphsNeedLayout:1; // see _usesParagraphLayouts
 		
 		unsigned int delegateActiveRangesForTextRenderer:1;
 		unsigned int delegateWillBecomeFirstResponder:1;
@@ -130,6 +211,10 @@ typedef enum {
 
 @property (nonatomic, strong) id<ABActiveTextRange> hitRange;
 
+// Active ranges for clicks and hover, indexed once when set so finding the one under the mouse is a binary search. Set them when the text changes instead of building them in -activeRangesForTextRenderer:, which is only asked when this is nil. While they're set, the range under the mouse is highlighted and the view redraws only when that range changes.
+@property (nonatomic, copy) NSArray *activeRanges;
+@property (nonatomic, readonly) id<ABActiveTextRange> hoveredActiveRange;
+
 @end
 
 #import "TUITextRenderer+Event.h"
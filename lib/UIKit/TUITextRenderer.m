@@ -15,12 +15,14 @@
  */
 
 #import "TUITextRenderer.h"
+#import "TUITextRenderer+Private.h"
 #import "ABActiveRange.h"
 #import "NSColor+TUIExtensions.h"
 #import "TUIAttributedString.h"
 #import "TUICGAdditions.h"
 #import "TUIStringDrawing.h"
 #import "TUIView.h"
+#import <libkern/OSAtomic.h>
 
 NSBezierPath* AB_NSBezierPathRoundedFromRects(CGRect rects[], CFIndex rectCount);
 NSBezierPath* AB_NSBezierPathRoundedFromRects(CGRect rects[], CFIndex rectCount)
@@ -137,21 +139,521 @@ NSBezierPath* AB_NSBezierPathRoundedFromRects(CGRect rects[], CFIndex rectCount)
 NSString *const TUITextRendererDidBecomeFirstResponder = @"TUITextRendererDidBecomeFirstResponder";
 NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidResignFirstResponder";
 
-@interface TUITextRenderer ()
-@property (nonatomic, strong) NSMutableDictionary *lineRects;
+CGFloat const TUITextLayoutUnconstrainedHeight = 1000000.0f;
+
+/*
+ The least recently used cache behind TUITextLayout and TUITextLine, safe to
+ use from any thread. Each object costs what it's stored with, and once the
+ total goes over the limit the least recently used are dropped until it's
+ down to three quarters of it, so that doesn't happen on every insert.
+ */
+@interface TUITextCache : NSObject {
+	OSSpinLock _lock;
+	NSMutableDictionary *_entries;
+	NSUInteger _cost;
+	NSUInteger _costLimit;
+	NSUInteger _clock;
+	NSUInteger _hitCount;
+	NSUInteger _missCount;
+}
+- (id)initWithCostLimit:(NSUInteger)limit;
+- (id)objectForKey:(id)key; // counts as a hit or a miss
+- (void)setObject:(id)object forKey:(id)key cost:(NSUInteger)cost;
+- (void)setCostLimit:(NSUInteger)limit;
+@property (nonatomic, readonly) NSUInteger hitCount;
+@property (nonatomic, readonly) NSUInteger missCount;
+@end
+
+@interface TUITextCacheEntry : NSObject
+@property (nonatomic, strong) id object;
+@property (nonatomic, assign) NSUInteger cost;
+@property (nonatomic, assign) NSUInteger lastUse;
+@end
+
+@implementation TUITextCacheEntry
+@synthesize object;
+@synthesize cost;
+@synthesize lastUse;
+@end
+
+@implementation TUITextCache
+
+@synthesize hitCount = _hitCount;
+@synthesize missCount = _missCount;
+
+- (id)initWithCostLimit:(NSUInteger)limit
+{
+	if((self = [super init])) {
+		_lock = OS_SPINLOCK_INIT;
+		_entries = [[NSMutableDictionary alloc] init];
+		_costLimit = limit;
+	}
+	return self;
+}
+
+// call with the lock held
+- (void)_trimToCostLimit
+{
+	if(_cost <= _costLimit)
+		return;
+	
+	NSArray *keys = [_entries keysSortedByValueUsingComparator:^NSComparisonResult(TUITextCacheEntry *a, TUITextCacheEntry *b) {
+		return a.lastUse < b.lastUse ? NSOrderedAscending : (a.lastUse > b.lastUse ? NSOrderedDescending : NSOrderedSame);
+	}];
+	for(id key in keys) {
+		if(_cost <= _costLimit / 4 * 3)
+			break;
+		_cost -= [[_entries objectForKey:key] cost];
+		[_entries removeObjectForKey:key];
+	}
+}
+
+- (id)objectForKey:(id)key
+{
+	OSSpinLockLock(&_lock);
+	TUITextCacheEntry *entry = [_entries objectForKey:key];
+	if(entry) {
+		_hitCount++;
+		entry.lastUse = ++_clock;
+	} else {
+		_missCount++;
+	}
+	id object = entry.object;
+	OSSpinLockUnlock(&_lock);
+	return object;
+}
+
+- (void)setObject:(id)object forKey:(id)key cost:(NSUInteger)cost
+{
+	TUITextCacheEntry *entry = [[TUITextCacheEntry alloc] init];
+	entry.object = object;
+	entry.cost = cost;
+	
+	OSSpinLockLock(&_lock);
+	entry.lastUse = ++_clock;
+	_cost -= [[_entries objectForKey:key] cost];
+	[_entries setObject:entry forKey:key];
+	_cost += cost;
+	[self _trimToCostLimit];
+	OSSpinLockUnlock(&_lock);
+}
+
+- (void)setCostLimit:(NSUInteger)limit
+{
+	OSSpinLockLock(&_lock);
+	_costLimit = limit;
+	[self _trimToCostLimit];
+	OSSpinLockUnlock(&_lock);
+}
+
+@end
+
+// keys are never changed once they're made, so copies can be the key itself
+@interface TUITextCacheKey : NSObject <NSCopying>
+@end
+
+@implementation TUITextCacheKey
+
+- (id)copyWithZone:(NSZone *)zone
+{
+	return self;
+}
+
+@end
+
+/*
+ Layout cache, see TUITextLayout. Layouts are built outside the lock, so two
+ threads asking for the same layout at once may both build it.
+ */
+@interface TUITextLayoutKey : TUITextCacheKey
+@property (nonatomic, copy) NSAttributedString *attributedString;
+@property (nonatomic, assign) CGFloat width;
+@property (nonatomic, assign) NSUInteger numberOfLines;
+@end
+
+@implementation TUITextLayoutKey
+
+@synthesize attributedString;
+@synthesize width;
+@synthesize numberOfLines;
+
+- (NSUInteger)hash
+{
+	return [self.attributedString hash] ^ ((NSUInteger)self.width << 8) ^ self.numberOfLines;
+}
+
+- (BOOL)isEqual:(id)object
+{
+	if(![object isKindOfClass:[TUITextLayoutKey class]])
+		return NO;
+	TUITextLayoutKey *other = object;
+	return self.width == other.width && self.numberOfLines == other.numberOfLines && [self.attributedString isEqualToAttributedString:other.attributedString];
+}
+
+@end
+
+@interface TUITextLayout ()
+@property (nonatomic, assign) NSUInteger bytes;
+- (id)_initWithAttributedString:(NSAttributedString *)attributedString width:(CGFloat)width numberOfLines:(NSUInteger)numberOfLines; // uncached
+@end
+
+static TUITextCache *TUITextLayoutGetCache(void)
+{
+	static TUITextCache *cache = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		cache = [[TUITextCache alloc] initWithCostLimit:8 * 1024 * 1024]; // bytes
+	});
+	return cache;
+}
+
+@implementation TUITextLayout
+
+@synthesize attributedString = _attributedString;
+@synthesize width = _width;
+@synthesize numberOfLines = _numberOfLines;
+@synthesize ctFrame = _ct_frame;
+@synthesize size = _size;
+@synthesize lineTable = _lineTable;
+@synthesize bytes;
+
+- (id)_initWithAttributedString:(NSAttributedString *)attributedString width:(CGFloat)width numberOfLines:(NSUInteger)numberOfLines
+{
+	if((self = [super init])) {
+		_attributedString = attributedString;
+		_width = width;
+		_numberOfLines = numberOfLines;
+		
+		CTFramesetterRef framesetter = CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)attributedString);
+		CGMutablePathRef path = CGPathCreateMutable();
+		CGPathAddRect(path, NULL, CGRectMake(0.0f, 0.0f, width, TUITextLayoutUnconstrainedHeight));
+		_ct_frame = CTFramesetterCreateFrame(framesetter, CFRangeMake(0, 0), path, NULL);
+		
+		NSArray *lines = (__bridge NSArray *)CTFrameGetLines(_ct_frame);
+		if(numberOfLines > 0 && lines.count > numberOfLines) {
+			// lay out just the text of the lines we're allowed
+			CFRange lastLineRange = CTLineGetStringRange((__bridge CTLineRef)[lines objectAtIndex:numberOfLines - 1]);
+			CFRelease(_ct_frame);
+			_ct_frame = CTFramesetterCreateFrame(framesetter, CFRangeMake(0, lastLineRange.location + lastLineRange.length), path, NULL);
+		}
+		CGPathRelease(path);
+		CFRelease(framesetter);
+		
+		_size = AB_CTFrameGetSize(_ct_frame);
+		_lineTable = AB_CTLineTableCreate(_ct_frame);
+		
+		// a rough guess at what Core Text holds on to, glyphs and advances for every character plus the lines,
+		// and at the copy of the string the cache key holds
+		bytes = 256 + [attributedString length] * 32 + _lineTable->lineCount * (sizeof(TUITextLayoutLine) + 256);
+		bytes += 128 + [attributedString length] * sizeof(unichar);
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	if(_ct_frame)
+		CFRelease(_ct_frame);
+	AB_CTLineTableRelease(_lineTable);
+}
+
+- (CFIndex)lineCount
+{
+	return _lineTable->lineCount;
+}
+
+- (const TUITextLayoutLine *)lines
+{
+	return _lineTable->lines;
+}
+
++ (TUITextLayout *)layoutForAttributedString:(NSAttributedString *)attributedString width:(CGFloat)width numberOfLines:(NSUInteger)numberOfLines
+{
+	TUITextLayoutKey *key = [[TUITextLayoutKey alloc] init];
+	key.attributedString = attributedString ?: [[NSAttributedString alloc] init];
+	key.width = width;
+	key.numberOfLines = numberOfLines;
+	
+	TUITextCache *cache = TUITextLayoutGetCache();
+	TUITextLayout *layout = [cache objectForKey:key];
+	if(layout)
+		return layout;
+	
+	layout = [[TUITextLayout alloc] _initWithAttributedString:key.attributedString width:width numberOfLines:numberOfLines];
+	[cache setObject:layout forKey:key cost:layout.bytes];
+	return layout;
+}
+
++ (void)setCacheByteLimit:(NSUInteger)limit
+{
+	[TUITextLayoutGetCache() setCostLimit:limit];
+}
+
++ (NSUInteger)cacheHitCount
+{
+	return TUITextLayoutGetCache().hitCount;
+}
+
++ (NSUInteger)cacheMissCount
+{
+	return TUITextLayoutGetCache().missCount;
+}
+
+@end
+
+/*
+ Line cache, see TUITextLine. Lines are small, so it's limited by count.
+ */
+@interface TUITextLineKey : TUITextCacheKey
+@property (nonatomic, copy) NSString *string;
+@property (nonatomic, strong) NSFont *font;
+@property (nonatomic, strong) NSColor *color;
+@property (nonatomic, assign) CGFloat kerning;
+@end
+
+@implementation TUITextLineKey
+
+@synthesize string;
+@synthesize font;
+@synthesize color;
+@synthesize kerning;
+
+- (NSUInteger)hash
+{
+	return [self.string hash] ^ [self.font hash] ^ ((NSUInteger)self.kerning << 4);
+}
+
+- (BOOL)isEqual:(id)object
+{
+	if(![object isKindOfClass:[TUITextLineKey class]])
+		return NO;
+	TUITextLineKey *other = object;
+	return self.kerning == other.kerning && [self.string isEqualToString:other.string] &&
+		(self.font == other.font || [self.font isEqual:other.font]) &&
+		(self.color == other.color || [self.color isEqual:other.color]);
+}
+
 @end
 
+static TUITextCache *TUITextLineGetCache(void)
+{
+	static TUITextCache *cache = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		cache = [[TUITextCache alloc] initWithCostLimit:512]; // lines, each costs 1
+	});
+	return cache;
+}
+
+@implementation TUITextLine
+
+@synthesize ctLine = _ct_line;
+@synthesize width = _width;
+@synthesize ascent = _ascent;
+@synthesize descent = _descent;
+@synthesize leading = _leading;
+
+- (id)_initWithKey:(TUITextLineKey *)key
+{
+	if((self = [super init])) {
+		// the same attributes TUIAttributedString would set
+		NSMutableDictionary *attributes = [NSMutableDictionary dictionaryWithCapacity:3];
+		if(key.font)
+			[attributes setObject:key.font forKey:(NSString *)kCTFontAttributeName];
+		if(key.color)
+			[attributes setObject:key.color forKey:NSForegroundColorAttributeName];
+		if(key.kerning != 0.0f)
+			[attributes setObject:[NSNumber numberWithFloat:key.kerning] forKey:(NSString *)kCTKernAttributeName];
+		
+		NSAttributedString *string = [[NSAttributedString alloc] initWithString:key.string attributes:attributes];
+		_ct_line = CTLineCreateWithAttributedString((__bridge CFAttributedStringRef)string);
+		_width = CTLineGetTypographicBounds(_ct_line, &_ascent, &_descent, &_leading);
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	if(_ct_line)
+		CFRelease(_ct_line);
+}
+
++ (TUITextLine *)lineForString:(NSString *)string font:(NSFont *)font color:(NSColor *)color kerning:(CGFloat)kerning
+{
+	TUITextLineKey *key = [[TUITextLineKey alloc] init];
+	key.string = string ?: @"";
+	key.font = font;
+	key.color = color;
+	key.kerning = kerning;
+	
+	TUITextCache *cache = TUITextLineGetCache();
+	TUITextLine *line = [cache objectForKey:key];
+	if(line)
+		return line;
+	
+	line = [[TUITextLine alloc] _initWithKey:key];
+	[cache setObject:line forKey:key cost:1];
+	return line;
+}
+
++ (void)setCacheCountLimit:(NSUInteger)limit
+{
+	[TUITextLineGetCache() setCostLimit:limit];
+}
+
++ (NSUInteger)cacheHitCount
+{
+	return TUITextLineGetCache().hitCount;
+}
+
++ (NSUInteger)cacheMissCount
+{
+	return TUITextLineGetCache().missCount;
+}
+
+- (void)drawAtPoint:(CGPoint)point inContext:(CGContextRef)context
+{
+	CGContextSetTextMatrix(context, CGAffineTransformIdentity);
+	CGContextSetTextPosition(context, point.x, point.y);
+	CTLineDraw(_ct_line, context);
+}
+
+@end
+
+// one paragraph of a renderer's text, see -_usesParagraphLayouts
+@interface TUITextParagraph : NSObject
+@property (nonatomic, assign) NSRange range;
+@property (nonatomic, strong) TUITextLayout *layout; // nil until laid out
+@property (nonatomic, assign) CGFloat top; // from the top of the text
+@property (nonatomic, assign) CGFloat height;
+@property (nonatomic, assign) CGFloat spacingBefore; // from its paragraph style, a frame of its own leaves these out
+@property (nonatomic, assign) CGFloat spacingAfter;
+@end
+
+@implementation TUITextParagraph
+
+@synthesize range;
+@synthesize layout;
+@synthesize top;
+@synthesize height;
+@synthesize spacingBefore;
+@synthesize spacingAfter;
+
+@end
+
+// The paragraph style attribute may be an NSParagraphStyle or a CTParagraphStyle, under the same name.
+static void TUITextGetParagraphSpacing(NSAttributedString *string, NSUInteger index, CGFloat *before, CGFloat *after)
+{
+	*before = *after = 0.0f;
+	id style = [string attribute:NSParagraphStyleAttributeName atIndex:index effectiveRange:NULL];
+	if([style isKindOfClass:[NSParagraphStyle class]]) {
+		*before = [style paragraphSpacingBefore];
+		*after = [style paragraphSpacing];
+	} else if(style && CFGetTypeID((__bridge CFTypeRef)style) == CTParagraphStyleGetTypeID()) {
+		CTParagraphStyleGetValueForSpecifier((__bridge CTParagraphStyleRef)style, kCTParagraphStyleSpecifierParagraphSpacingBefore, sizeof(CGFloat), before);
+		CTParagraphStyleGetValueForSpecifier((__bridge CTParagraphStyleRef)style, kCTParagraphStyleSpecifierParagraphSpacing, sizeof(CGFloat), after);
+	}
+}
+
+// Rects asked for by range since a renderer's frame was laid out. Entries are
+// sorted by range then aggregation type and their rects live in one buffer,
+// so looking up a range is a binary search and no objects are made per range.
+#define TUITextRectCacheMaxRects 100
+
+typedef struct {
+	CFRange range;
+	AB_CTLineRectAggregationType aggregationType;
+	CFIndex firstRect;
+	CFIndex rectCount;
+} TUITextRectCacheEntry;
+
+struct TUITextRectCache {
+	TUITextRectCacheEntry *entries;
+	CFIndex entryCount;
+	CFIndex entryCapacity;
+	CGRect *rects;
+	CFIndex rectCount;
+	CFIndex rectCapacity;
+};
+
+static void TUITextRectCacheRelease(struct TUITextRectCache *cache)
+{
+	if(!cache)
+		return;
+	free(cache->entries);
+	free(cache->rects);
+	free(cache);
+}
+
+static inline int TUITextRectCacheEntryCompare(TUITextRectCacheEntry *entry, CFRange range, AB_CTLineRectAggregationType aggregationType)
+{
+	if(entry->range.location != range.location)
+		return entry->range.location < range.location ? -1 : 1;
+	if(entry->range.length != range.length)
+		return entry->range.length < range.length ? -1 : 1;
+	if(entry->aggregationType != aggregationType)
+		return entry->aggregationType < aggregationType ? -1 : 1;
+	return 0;
+}
+
+// An active range in a renderer's index, order is its place in the activeRanges
+// array. The entries are sorted by location and read as an interval tree: the
+// root of [lo, hi) is the middle entry, and maxEnd is the furthest end in the
+// subtree rooted there, so a lookup skips any subtree that can't reach the index.
+struct TUIActiveRangeIndexEntry {
+	NSUInteger location;
+	NSUInteger end;
+	NSUInteger maxEnd;
+	NSUInteger order;
+};
+
+static int TUIActiveRangeIndexEntryCompare(const void *a, const void *b)
+{
+	const struct TUIActiveRangeIndexEntry *x = a;
+	const struct TUIActiveRangeIndexEntry *y = b;
+	if(x->location != y->location)
+		return x->location < y->location ? -1 : 1;
+	return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+static NSUInteger TUIActiveRangeIndexBuild(struct TUIActiveRangeIndexEntry *entries, NSUInteger lo, NSUInteger hi)
+{
+	if(lo >= hi)
+		return 0;
+	NSUInteger mid = (lo + hi) / 2;
+	NSUInteger maxEnd = MAX(entries[mid].end, MAX(TUIActiveRangeIndexBuild(entries, lo, mid), TUIActiveRangeIndexBuild(entries, mid + 1, hi)));
+	entries[mid].maxEnd = maxEnd;
+	return maxEnd;
+}
+
+// lowers *found to the order of any range in [lo, hi) that covers index
+static void TUIActiveRangeIndexSearch(struct TUIActiveRangeIndexEntry *entries, NSUInteger lo, NSUInteger hi, NSUInteger index, NSUInteger *found)
+{
+	while(lo < hi) {
+		NSUInteger mid = (lo + hi) / 2;
+		struct TUIActiveRangeIndexEntry *entry = &entries[mid];
+		if(entry->maxEnd <= index)
+			return; // nothing in this subtree reaches index
+		TUIActiveRangeIndexSearch(entries, lo, mid, index, found);
+		if(entry->location > index)
+			return; // it and everything after it start past index
+		if(entry->end > index && entry->order < *found)
+			*found = entry->order;
+		lo = mid + 1;
+	}
+}
+
 @implementation TUITextRenderer
 
 @synthesize attributedString;
 @synthesize frame;
 @synthesize view;
 @synthesize hitRange;
+@synthesize hoveredActiveRange = _hoveredActiveRange;
 @synthesize shadowColor;
 @synthesize shadowOffset;
 @synthesize shadowBlur;
 @synthesize verticalAlignment;
-@synthesize lineRects;
 
 - (void)_resetFrame
 {
@@ -163,8 +665,13 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 		CGPathRelease(_ct_path);
 		_ct_path = NULL;
 	}
+	_layout = nil;
+	_ct_offset = CGPointZero;
+	AB_CTLineTableRelease(_ct_lines);
+	_ct_lines = NULL;
 	
-	lineRects = nil;
+	TUITextRectCacheRelease(_rectCache);
+	_rectCache = NULL;
 }
 
 - (void)_resetFramesetter
@@ -173,6 +680,7 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 		CFRelease(_ct_framesetter);
 		_ct_framesetter = NULL;
 	}
+	_paragraphs = nil;
 	
 	[self _resetFrame];
 }
@@ -188,67 +696,346 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 - (void)dealloc
 {
 	[self _resetFramesetter];
+	free(_activeRangeIndex);
 }
 
-- (void)_buildFrameWithEffectiveFrame:(CGRect)effectiveFrame
+// TUITextVerticalAlignmentTop is how Core Text always lays out. For Middle and Bottom the laid out lines are moved down, never laid out again.
+- (CGFloat)_verticalAlignmentOffsetForTextHeight:(CGFloat)height
 {
-	[self _resetFrame];
-	
-	_ct_path = CGPathCreateMutable();
-	CGPathAddRect((CGMutablePathRef)_ct_path, NULL, effectiveFrame);
-	_ct_frame = CTFramesetterCreateFrame(_ct_framesetter, CFRangeMake(0, 0), _ct_path, NULL);
+	CGFloat space = MAX(frame.size.height - height, 0.0f);
+	switch(verticalAlignment) {
+		case TUITextVerticalAlignmentTop:
+			return 0.0f;
+		case TUITextVerticalAlignmentMiddle:
+			return -roundf(space / 2);
+		case TUITextVerticalAlignmentBottom:
+			return -roundf(space);
+	}
+	return 0.0f;
+}
+
+// Editors change their text on every keystroke, so their layouts would only
+// push everyone else's out of the shared cache.
+- (TUITextLayout *)_layoutForAttributedString:(NSAttributedString *)string width:(CGFloat)width numberOfLines:(NSUInteger)numberOfLines
+{
+	if(_flags.bypassesLayoutCache)
+		return [[TUITextLayout alloc] _initWithAttributedString:[string copy] ?: [[NSAttributedString alloc] init] width:width numberOfLines:numberOfLines];
+	return [TUITextLayout layoutForAttributedString:string width:width numberOfLines:numberOfLines];
 }
 
 - (void)_buildFrame
 {
 	if(!_ct_path) {
-		[self _buildFrameWithEffectiveFrame:frame];
+		TUITextLayout *layout = [self _layoutForAttributedString:self.drawingAttributedString width:frame.size.width numberOfLines:0];
+		if(layout.size.height <= frame.size.height) {
+			// All of the text fits, so the shared layout has the same lines a
+			// frame of our own would, just somewhere else.
+			_layout = layout;
+			_ct_frame = CFRetain(layout.ctFrame);
+			_ct_path = CGPathRetain(CTFrameGetPath(_ct_frame));
+			_ct_offset = CGPointMake(frame.origin.x, CGRectGetMaxY(frame) - TUITextLayoutUnconstrainedHeight + [self _verticalAlignmentOffsetForTextHeight:layout.size.height]);
+			return;
+		}
+		
+		// only the lines that fit, laid out in our frame
+		_ct_path = CGPathCreateMutable();
+		CGPathAddRect((CGMutablePathRef)_ct_path, NULL, frame);
+		_ct_frame = CTFramesetterCreateFrame([self ctFramesetter], CFRangeMake(0, 0), _ct_path, NULL);
 		
-		// TUITextVerticalAlignmentTop is easy since that's how Core Text always draws. For Middle and Bottom we have to shift the CTFrame down.
 		if(verticalAlignment != TUITextVerticalAlignmentTop) {
-			CGRect effectiveFrame = frame;
-			
-			CGSize size = AB_CTFrameGetSize(_ct_frame);
-			if(verticalAlignment == TUITextVerticalAlignmentMiddle) {
-				effectiveFrame.origin.y = size.height/2 - frame.size.height/2;
-			} else if(verticalAlignment == TUITextVerticalAlignmentBottom) {
-				effectiveFrame.origin.y = size.height;
+			// line origins are relative to the bottom of the frame
+			NSArray *lines = (__bridge NSArray *)CTFrameGetLines(_ct_frame);
+			if(lines.count > 0) {
+				CGPoint lastLineOrigin;
+				CGFloat descent;
+				CTFrameGetLineOrigins(_ct_frame, CFRangeMake(lines.count - 1, 1), &lastLineOrigin);
+				CTLineGetTypographicBounds((__bridge CTLineRef)[lines lastObject], NULL, &descent, NULL);
+				_ct_offset.y = [self _verticalAlignmentOffsetForTextHeight:ceil(frame.size.height - lastLineOrigin.y + descent)];
 			}
-			
-			effectiveFrame = CGRectIntegral(effectiveFrame);
-			
-			[self _buildFrameWithEffectiveFrame:effectiveFrame];
 		}
 	}
 }
 
-- (void)_buildFramesetter
+- (CTFramesetterRef)ctFramesetter
 {
 	if(!_ct_framesetter) {
 		_ct_framesetter = CTFramesetterCreateWithAttributedString((__bridge CFAttributedStringRef)self.drawingAttributedString);
 	}
-	
-	[self _buildFrame];
-}
-
-- (CTFramesetterRef)ctFramesetter
-{
-	[self _buildFramesetter];
 	return _ct_framesetter;
 }
 
 - (CTFrameRef)ctFrame
 {
-	[self _buildFramesetter];
+	[self _buildFrame];
 	return _ct_frame;
 }
 
 - (CGPathRef)ctPath
 {
-	[self _buildFramesetter];
+	[self _buildFrame];
 	return _ct_path;
 }
 
+- (AB_CTLineTable *)_lineTable
+{
+	[self _buildFrame];
+	if(_layout)
+		return _layout.lineTable;
+	if(!_ct_lines && _ct_frame)
+		_ct_lines = AB_CTLineTableCreate(_ct_frame);
+	return _ct_lines;
+}
+
+- (void)_getRects:(CGRect *)rects count:(CFIndex *)rectCount forCharacterRange:(CFRange)range aggregationType:(AB_CTLineRectAggregationType)aggregationType
+{
+	if([self _usesParagraphLayouts]) {
+		[self _getParagraphRects:rects count:rectCount forCharacterRange:range aggregationType:aggregationType];
+		return;
+	}
+	
+	AB_CTLineTableGetRectsForRange([self _lineTable], range, aggregationType, rects, rectCount);
+	for(CFIndex i = 0; i < *rectCount; ++i) {
+		rects[i] = CGRectOffset(rects[i], _ct_offset.x, _ct_offset.y);
+	}
+}
+
+- (void)_getCachedRects:(CGRect *)rects count:(CFIndex *)rectCount forCharacterRange:(CFRange)range aggregationType:(AB_CTLineRectAggregationType)aggregationType
+{
+	if(!_rectCache)
+		_rectCache = calloc(1, sizeof(struct TUITextRectCache));
+	struct TUITextRectCache *cache = _rectCache;
+	
+	CFIndex lo = 0, hi = cache->entryCount;
+	while(lo < hi) {
+		CFIndex mid = (lo + hi) / 2;
+		if(TUITextRectCacheEntryCompare(&cache->entries[mid], range, aggregationType) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	
+	if(lo == cache->entryCount || TUITextRectCacheEntryCompare(&cache->entries[lo], range, aggregationType) != 0) {
+		CGRect found[TUITextRectCacheMaxRects];
+		CFIndex foundCount = TUITextRectCacheMaxRects;
+		[self _getRects:found count:&foundCount forCharacterRange:range aggregationType:aggregationType];
+		
+		if(cache->rectCount + foundCount > cache->rectCapacity) {
+			cache->rectCapacity = MAX(cache->rectCapacity * 2, cache->rectCount + foundCount);
+			cache->rects = realloc(cache->rects, sizeof(CGRect) * cache->rectCapacity);
+		}
+		if(cache->entryCount == cache->entryCapacity) {
+			cache->entryCapacity = MAX(cache->entryCapacity * 2, 16);
+			cache->entries = realloc(cache->entries, sizeof(TUITextRectCacheEntry) * cache->entryCapacity);
+		}
+		
+		// drawing asks for ranges in order, so this is almost always an append
+		memmove(cache->entries + lo + 1, cache->entries + lo, sizeof(TUITextRectCacheEntry) * (cache->entryCount - lo));
+		cache->entries[lo] = (TUITextRectCacheEntry){range, aggregationType, cache->rectCount, foundCount};
+		cache->entryCount++;
+		memcpy(cache->rects + cache->rectCount, found, sizeof(CGRect) * foundCount);
+		cache->rectCount += foundCount;
+	}
+	
+	TUITextRectCacheEntry *entry = &cache->entries[lo];
+	*rectCount = MIN(*rectCount, entry->rectCount);
+	memcpy(rects, cache->rects + entry->firstRect, sizeof(CGRect) * *rectCount);
+}
+
+#pragma mark Paragraph layouts
+
+- (void)_splitParagraphsInRange:(NSRange)range intoArray:(NSMutableArray *)paragraphs atIndex:(NSUInteger)index
+{
+	NSString *string = [self.drawingAttributedString string];
+	NSUInteger location = range.location;
+	while(location < NSMaxRange(range)) {
+		TUITextParagraph *paragraph = [[TUITextParagraph alloc] init];
+		paragraph.range = [string paragraphRangeForRange:NSMakeRange(location, 0)];
+		[paragraphs insertObject:paragraph atIndex:index++];
+		location = NSMaxRange(paragraph.range);
+	}
+}
+
+// NO if the text isn't laid out by paragraph, otherwise brings the paragraphs
+// and _paragraphsSize up to date with the text and width
+- (BOOL)_updateParagraphLayouts
+{
+	NSAttributedString *string = self.drawingAttributedString;
+	if(!_flags.layoutsByParagraph || string != attributedString || [string length] == 0)
+		return NO;
+	
+	if(!_paragraphs) {
+		_paragraphs = [[NSMutableArray alloc] init];
+		[self _splitParagraphsInRange:NSMakeRange(0, [string length]) intoArray:_paragraphs atIndex:0];
+		_flags.paragraphsNeedLayout = 1;
+	}
+	
+	BOOL widthChanged = (_paragraphsWidth != frame.size.width);
+	_paragraphsWidth = frame.size.width;
+	if(!widthChanged && !_flags.paragraphsNeedLayout)
+		return YES;
+	_flags.paragraphsNeedLayout = 0;
+	
+	// lay out whatever changed, the rest only move
+	CGSize size = CGSizeZero;
+	TUITextParagraph *previous = nil;
+	for(TUITextParagraph *paragraph in _paragraphs) {
+		if(!paragraph.layout || widthChanged) {
+			paragraph.layout = [self _layoutForAttributedString:[string attributedSubstringFromRange:paragraph.range] width:frame.size.width numberOfLines:0];
+			// leave room for the last line's leading, as one frame would
+			TUITextLayout *layout = paragraph.layout;
+			paragraph.height = layout.size.height + (layout.lineCount > 0 ? ceil(layout.lines[layout.lineCount - 1].leading) : 0.0f);
+			
+			CGFloat before, after;
+			TUITextGetParagraphSpacing(string, paragraph.range.location, &before, &after);
+			paragraph.spacingBefore = before;
+			paragraph.spacingAfter = after;
+		}
+		if(previous)
+			size.height += previous.spacingAfter + paragraph.spacingBefore;
+		paragraph.top = size.height;
+		size.height += paragraph.height;
+		size.width = MAX(size.width, paragraph.layout.size.width);
+		previous = paragraph;
+	}
+	if(_paragraphs.count > 0) {
+		// no leading after the last line
+		TUITextParagraph *last = [_paragraphs lastObject];
+		size.height -= last.height - last.layout.size.height;
+	}
+	_paragraphsSize = size;
+	return YES;
+}
+
+- (BOOL)_usesParagraphLayouts
+{
+	return [self _updateParagraphLayouts];
+}
+
+- (NSArray *)_paragraphRanges
+{
+	NSMutableArray *ranges = [NSMutableArray arrayWithCapacity:_paragraphs.count];
+	for(TUITextParagraph *paragraph in _paragraphs)
+		[ranges addObject:[NSValue valueWithRange:paragraph.range]];
+	return ranges;
+}
+
+// from a paragraph layout's coordinates to ours
+- (CGPoint)_offsetForParagraph:(TUITextParagraph *)paragraph
+{
+	return CGPointMake(frame.origin.x, CGRectGetMaxY(frame) + [self _verticalAlignmentOffsetForTextHeight:_paragraphsSize.height] - paragraph.top - TUITextLayoutUnconstrainedHeight);
+}
+
+- (void)_drawParagraphsInContext:(CGContextRef)context
+{
+	if(_paragraphsSize.height > frame.size.height)
+		CGContextClipToRect(context, frame); // text that doesn't fit is cut off
+	CGRect clip = CGContextGetClipBoundingBox(context);
+	for(TUITextParagraph *paragraph in _paragraphs) {
+		CGPoint offset = [self _offsetForParagraph:paragraph];
+		CGFloat top = offset.y + TUITextLayoutUnconstrainedHeight;
+		if(top - paragraph.height > CGRectGetMaxY(clip))
+			continue;
+		if(top < CGRectGetMinY(clip))
+			break;
+		
+		CGContextSaveGState(context);
+		CGContextTranslateCTM(context, offset.x, offset.y);
+		CTFrameDraw(paragraph.layout.ctFrame, context);
+		CGContextRestoreGState(context);
+	}
+}
+
+- (void)_getParagraphRects:(CGRect *)rects count:(CFIndex *)rectCount forCharacterRange:(CFRange)range aggregationType:(AB_CTLineRectAggregationType)aggregationType
+{
+	CFIndex maxRects = *rectCount;
+	CFIndex n = 0;
+	CFIndex end = range.location + range.length;
+	NSUInteger paragraphCount = _paragraphs.count;
+	for(NSUInteger i = 0; i < paragraphCount && n < maxRects; ++i) {
+		TUITextParagraph *paragraph = [_paragraphs objectAtIndex:i];
+		CFIndex start = paragraph.range.location;
+		CFIndex stop = NSMaxRange(paragraph.range);
+		// an empty range belongs to the paragraph it's in, or the last one at the very end
+		BOOL contains = (range.length == 0) ? (range.location >= start && (range.location < stop || i == paragraphCount - 1)) : (range.location < stop && end > start);
+		if(!contains)
+			continue;
+		
+		CFIndex localStart = MAX(range.location, start) - start;
+		CFIndex localEnd = MIN(end, stop) - start;
+		CFIndex count = maxRects - n;
+		AB_CTLineTableGetRectsForRange(paragraph.layout.lineTable, CFRangeMake(localStart, localEnd - localStart), aggregationType, rects + n, &count);
+		
+		CGPoint offset = [self _offsetForParagraph:paragraph];
+		for(CFIndex j = n; j < n + count; ++j) {
+			rects[j] = CGRectOffset(rects[j], offset.x, offset.y);
+		}
+		n += count;
+		
+		if(range.length == 0 || end <= stop)
+			break;
+	}
+	*rectCount = n;
+}
+
+- (CFIndex)_paragraphStringIndexForPoint:(CGPoint)p
+{
+	p.x += frame.origin.x;
+	p.y += frame.origin.y;
+	for(TUITextParagraph *paragraph in _paragraphs) {
+		CGPoint offset = [self _offsetForParagraph:paragraph];
+		CGFloat bottom = offset.y + TUITextLayoutUnconstrainedHeight - paragraph.height;
+		if(p.y > bottom || paragraph == [_paragraphs lastObject]) {
+			CFIndex index = AB_CTLineTableGetStringIndexForPosition(paragraph.layout.lineTable, CGPointMake(p.x - offset.x, p.y - offset.y));
+			return paragraph.range.location + index;
+		}
+	}
+	return 0;
+}
+
+- (void)_attributedStringDidChangeInRange:(NSRange)range changeInLength:(NSInteger)delta
+{
+	if(_ct_framesetter) {
+		CFRelease(_ct_framesetter);
+		_ct_framesetter = NULL;
+	}
+	[self _resetFrame];
+	
+	if(!_paragraphs || _paragraphs.count == 0) {
+		_paragraphs = nil;
+		return;
+	}
+	
+	// Find the paragraphs the old characters were in. Ending right at the start
+	// of a paragraph still touches it, the newline before it may be gone.
+	NSUInteger oldStart = range.location;
+	NSUInteger oldEnd = NSMaxRange(range) - delta;
+	NSUInteger first = NSNotFound, last = NSNotFound;
+	NSUInteger count = _paragraphs.count;
+	for(NSUInteger i = 0; i < count; ++i) {
+		NSRange r = [[_paragraphs objectAtIndex:i] range];
+		if(first == NSNotFound && (oldStart < NSMaxRange(r) || i == count - 1))
+			first = i;
+		if(first != NSNotFound && (oldEnd < NSMaxRange(r) || i == count - 1)) {
+			last = i;
+			break;
+		}
+	}
+	
+	NSUInteger start = [[_paragraphs objectAtIndex:first] range].location;
+	NSUInteger end = NSMaxRange([[_paragraphs objectAtIndex:last] range]) + delta;
+	[_paragraphs removeObjectsInRange:NSMakeRange(first, last - first + 1)];
+	
+	for(NSUInteger i = first; i < _paragraphs.count; ++i) {
+		TUITextParagraph *paragraph = [_paragraphs objectAtIndex:i];
+		NSRange r = paragraph.range;
+		r.location += delta;
+		paragraph.range = r;
+	}
+	
+	[self _splitParagraphsInRange:NSMakeRange(start, end - start) intoArray:_paragraphs atIndex:first];
+	_flags.paragraphsNeedLayout = 1;
+}
+
 - (CFIndex)_clampToValidRange:(CFIndex)index
 {
 	if(index < 0) return 0;
@@ -351,13 +1138,9 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 				CGContextSaveGState(context);
 				
 				AB_CTLineRectAggregationType aggregationType = (AB_CTLineRectAggregationType) [[self.drawingAttributedString attribute:TUIAttributedStringBackgroundFillStyleName atIndex:range.location effectiveRange:NULL] integerValue];
-				NSArray *rectsArray = [self rectsForCharacterRange:CFRangeMake(range.location, range.length) aggregationType:aggregationType];
-				
-				CFIndex rectCount = rectsArray.count;
+				CFIndex rectCount = TUITextRectCacheMaxRects;
 				CGRect rects[rectCount];
-				for(NSUInteger i = 0; i < rectCount; i++) {
-					rects[i] = [[rectsArray objectAtIndex:i] rectValue];
-				}
+				[self _getCachedRects:rects count:&rectCount forCharacterRange:CFRangeMake(range.location, range.length) aggregationType:aggregationType];
 				
 				TUIAttributedStringPreDrawBlock block = value;
 				block(self.drawingAttributedString, range, rects, rectCount);
@@ -376,13 +1159,9 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 				CGContextSetFillColorWithColor(context, color);
 				
 				AB_CTLineRectAggregationType aggregationType = (AB_CTLineRectAggregationType) [[self.drawingAttributedString attribute:TUIAttributedStringBackgroundFillStyleName atIndex:range.location effectiveRange:NULL] integerValue];
-				NSArray *rectsArray = [self rectsForCharacterRange:CFRangeMake(range.location, range.length) aggregationType:aggregationType];
-				
-				CFIndex rectCount = rectsArray.count;
+				CFIndex rectCount = TUITextRectCacheMaxRects;
 				CGRect rects[rectCount];
-				for(NSUInteger i = 0; i < rectCount; i++) {
-					rects[i] = [[rectsArray objectAtIndex:i] rectValue];
-				}
+				[self _getCachedRects:rects count:&rectCount forCharacterRange:CFRangeMake(range.location, range.length) aggregationType:aggregationType];
 				
 				for(CFIndex i = 0; i < rectCount; ++i) {
 					CGRect r = rects[i];
@@ -396,16 +1175,16 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 			CGContextRestoreGState(context);
 		}
 		
-		CTFrameRef f = [self ctFrame];
-		if(hitRange && !_flags.drawMaskDragSelection) {
+		id<ABActiveTextRange> highlightRange = hitRange ?: _hoveredActiveRange;
+		if(highlightRange && !_flags.drawMaskDragSelection) {
 			// draw highlight
 			CGContextSaveGState(context);
 			
-			NSRange _r = [hitRange rangeValue];
+			NSRange _r = [highlightRange rangeValue];
 			CFRange r = {_r.location, _r.length};
 			CFIndex nRects = 10;
 			CGRect rects[nRects];
-			AB_CTFrameGetRectsForRange(f, r, rects, &nRects);
+			[self _getRects:rects count:&nRects forCharacterRange:r aggregationType:AB_CTLineRectAggregationTypeInline];
 			for(int i = 0; i < nRects; ++i) {
 				CGRect rect = rects[i];
 				rect = CGRectInset(rect, -2, -1);
@@ -428,7 +1207,7 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 			// draw (or mask) selection
 			CFIndex rectCount = 100;
 			CGRect rects[rectCount];
-			AB_CTFrameGetRectsForRange(f, selectedRange, rects, &rectCount);
+			[self _getRects:rects count:&rectCount forCharacterRange:selectedRange aggregationType:AB_CTLineRectAggregationTypeInline];
 			if(_flags.drawMaskDragSelection) {
 				CGContextClipToRects(context, rects, rectCount);
 			} else {
@@ -440,7 +1219,12 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 			CGContextSetShadowWithColor(context, shadowOffset, shadowBlur, shadowColor.tui_CGColor);
 		
 		CGContextSetTextMatrix(context, CGAffineTransformIdentity);
-		CTFrameDraw(f, context);
+		if([self _usesParagraphLayouts]) {
+			[self _drawParagraphsInContext:context];
+		} else {
+			CGContextTranslateCTM(context, _ct_offset.x, _ct_offset.y);
+			CTFrameDraw([self ctFrame], context);
+		}
 		CGContextRestoreGState(context);
 	}
 }
@@ -456,6 +1240,8 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 - (CGSize)size
 {
 	if(attributedString) {
+		if([self _usesParagraphLayouts])
+			return _paragraphsSize;
 		return AB_CTFrameGetSize([self ctFrame]);
 	}
 	return CGSizeZero;
@@ -463,27 +1249,17 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 
 - (CGSize)sizeConstrainedToWidth:(CGFloat)width
 {
-	if(attributedString) {
-		CGRect oldFrame = frame;
-		self.frame = CGRectMake(0.0f, 0.0f, width, 1000000.0f);
-
-		CGSize size = [self size];
-		
-		self.frame = oldFrame;
-		
-		return size;
-	}
-	return CGSizeZero;
+	return [self sizeConstrainedToWidth:width numberOfLines:0];
 }
 
 - (CGSize)sizeConstrainedToWidth:(CGFloat)width numberOfLines:(NSUInteger)numberOfLines
 {
-	NSMutableAttributedString *fake = [self.drawingAttributedString mutableCopy];
-	[fake replaceCharactersInRange:NSMakeRange(0, [fake length]) withString:@"M"];
-	CGFloat singleLineHeight = [fake ab_sizeConstrainedToWidth:width].height;
-	CGFloat maxHeight = singleLineHeight * numberOfLines;
-	CGSize size = [self sizeConstrainedToWidth:width];
-	return CGSizeMake(size.width, MIN(maxHeight, size.height));
+	if(attributedString) {
+		if(numberOfLines == 0 && width == frame.size.width && [self _updateParagraphLayouts])
+			return _paragraphsSize; // e.g. an editor sizing itself to fit its text
+		return [self _layoutForAttributedString:self.drawingAttributedString width:width numberOfLines:numberOfLines].size;
+	}
+	return CGSizeZero;
 }
 
 - (void)setAttributedString:(NSAttributedString *)a
@@ -508,7 +1284,7 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 {
 	CFIndex rectCount = 1;
 	CGRect rects[rectCount];
-	AB_CTFrameGetRectsForRange([self ctFrame], range, rects, &rectCount);
+	[self _getRects:rects count:&rectCount forCharacterRange:range aggregationType:AB_CTLineRectAggregationTypeInline];
 	if(rectCount > 0) {
 		return rects[0];
 	}
@@ -522,27 +1298,81 @@ NSString *const TUITextRendererDidResignFirstResponder = @"TUITextRendererDidRes
 
 - (NSArray *)rectsForCharacterRange:(CFRange)range aggregationType:(AB_CTLineRectAggregationType)aggregationType
 {
-	if(self.lineRects == nil) {
-		self.lineRects = [NSMutableDictionary dictionary];
+	CFIndex rectCount = TUITextRectCacheMaxRects;
+	CGRect rects[rectCount];
+	[self _getCachedRects:rects count:&rectCount forCharacterRange:range aggregationType:aggregationType];
+	
+	NSMutableArray *wrappedRects = [NSMutableArray arrayWithCapacity:rectCount];
+	for(CFIndex i = 0; i < rectCount; i++) {
+		[wrappedRects addObject:[NSValue valueWithRect:rects[i]]];
 	}
+	return wrappedRects;
+}
+
+- (NSArray *)activeRanges
+{
+	return _activeRanges;
+}
+
+- (void)setActiveRanges:(NSArray *)ranges
+{
+	_activeRanges = [ranges copy];
 	
-	NSValue *cacheKey = [NSValue valueWithRange:NSMakeRange(range.location, range.length)];
-	NSArray *cachedRects = [self.lineRects objectForKey:cacheKey];
-	if(cachedRects == nil) {
-		CFIndex rectCount = 100;
-		CGRect rects[rectCount];
-		AB_CTFrameGetRectsForRangeWithAggregationType([self ctFrame], range, aggregationType, rects, &rectCount);
-		
-		NSMutableArray *wrappedRects = [NSMutableArray arrayWithCapacity:rectCount];
-		for(CFIndex i = 0; i < rectCount; i++) {
-			[wrappedRects addObject:[NSValue valueWithRect:rects[i]]];
+	free(_activeRangeIndex);
+	_activeRangeIndex = NULL;
+	NSUInteger count = [_activeRanges count];
+	if(count > 0) {
+		_activeRangeIndex = malloc(sizeof(struct TUIActiveRangeIndexEntry) * count);
+		NSUInteger i = 0;
+		for(id<ABActiveTextRange> activeRange in _activeRanges) {
+			NSRange r = [activeRange rangeValue];
+			_activeRangeIndex[i] = (struct TUIActiveRangeIndexEntry){r.location, NSMaxRange(r), 0, i};
+			i++;
 		}
-		
-		[self.lineRects setObject:wrappedRects forKey:cacheKey];
-		cachedRects = wrappedRects;
+		qsort(_activeRangeIndex, count, sizeof(struct TUIActiveRangeIndexEntry), TUIActiveRangeIndexEntryCompare);
+		TUIActiveRangeIndexBuild(_activeRangeIndex, 0, count);
+	}
+	
+	if(_hoveredActiveRange) {
+		[view setNeedsDisplayInRect:CGRectInset([self rectForRange:ABCFRangeFromNSRange([_hoveredActiveRange rangeValue])], -12, -12)];
+		_hoveredActiveRange = nil;
 	}
+}
+
+- (id<ABActiveTextRange>)_activeRangeForStringIndex:(CFIndex)index
+{
+	if(!_activeRanges) {
+		if(_flags.delegateActiveRangesForTextRenderer)
+			return [self rangeInRanges:[delegate activeRangesForTextRenderer:self] forStringIndex:index];
+		return nil;
+	}
+	if(index < 0)
+		return nil;
+	
+	// overlapping ranges resolve to the first in the array, like -rangeInRanges:forStringIndex:
+	NSUInteger found = NSNotFound;
+	TUIActiveRangeIndexSearch(_activeRangeIndex, 0, [_activeRanges count], (NSUInteger)index, &found);
+	return (found == NSNotFound) ? nil : [_activeRanges objectAtIndex:found];
+}
+
+- (void)_updateHoveredActiveRangeWithEvent:(NSEvent *)event
+{
+	if(!_activeRanges && !_hoveredActiveRange)
+		return;
+	
+	id<ABActiveTextRange> range = event ? [self _activeRangeForStringIndex:[self stringIndexForEvent:event]] : nil;
+	if(range == _hoveredActiveRange)
+		return;
+	
+	CGRect dirtyRect = CGRectNull;
+	if(_hoveredActiveRange)
+		dirtyRect = [self rectForRange:ABCFRangeFromNSRange([_hoveredActiveRange rangeValue])];
+	if(range)
+		dirtyRect = CGRectUnion(dirtyRect, [self rectForRange:ABCFRangeFromNSRange([range rangeValue])]);
+	_hoveredActiveRange = range;
 	
-	return cachedRects;
+	if(!CGRectIsNull(dirtyRect))
+		[view setNeedsDisplayInRect:CGRectInset(dirtyRect, -12, -12)]; // room for the highlight's glow
 }
 
 - (BOOL)backgroundDrawingEnabled
@@ -37,7 +37,9 @@
 	
 	BOOL spellCheckingEnabled;
 	NSInteger lastCheckToken;
-	NSArray *lastCheckResults;
+	NSArray *lastCheckResults; // misspellings underlined now
+	NSRange spellCheckRange; // edited since the last check, location is NSNotFound when there's nothing to check
+	NSUInteger textGeneration; // bumped on every edit, results for older text are dropped
 	NSTextCheckingResult *selectedTextCheckingResult;
 	BOOL autocorrectionEnabled;
 	NSMutableDictionary *autocorrectedResults;
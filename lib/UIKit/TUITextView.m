@@ -20,6 +20,10 @@
 #import "TUINSWindow.h"
 #import "TUITextViewEditor.h"
 #import "NSColor+TUIExtensions.h"
+#import "TUITextRenderer+Private.h"
+
+// how long typing has to pause before the edited text is spell checked
+static NSTimeInterval const TUITextViewSpellCheckingDelay = 0.3;
 
 @interface TUITextViewAutocorrectedPair : NSObject <NSCopying> {
 	NSTextCheckingResult *correctionResult;
@@ -53,8 +57,15 @@
 }
 @end
 
+@interface TUITextEditor ()
+- (void)_textDidChangeInRange:(NSRange)range changeInLength:(NSInteger)delta;
+@end
+
 @interface TUITextView () <TUITextRendererDelegate>
 - (void)_checkSpelling;
+- (void)_applySpellingResults:(NSArray *)results inRange:(NSRange)checkRange;
+- (void)_updateSpellCheckingForChangeInRange:(NSRange)range changeInLength:(NSInteger)delta;
+- (void)_resetSpellChecking;
 - (void)_replaceMisspelledWord:(NSMenuItem *)menuItem;
 - (CGRect)_cursorRect;
 
@@ -120,6 +131,8 @@
 	if((self = [super initWithFrame:frame])) {
 		self.backgroundColor = [NSColor clearColor];
 		
+		spellCheckRange = NSMakeRange(NSNotFound, 0);
+		
 		renderer = [[[self textEditorClass] alloc] init];
 		renderer.delegate = self;
 		self.textRenderers = [NSArray arrayWithObject:renderer];
@@ -405,89 +418,197 @@ static CAAnimation *ThrobAnimation()
 		[delegate textViewDidChange:self];
 	
 	if(spellCheckingEnabled) {
-		[self _checkSpelling];
+		// wait for a pause in typing
+		[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(_checkSpelling) object:nil];
+		[self performSelector:@selector(_checkSpelling) withObject:nil afterDelay:TUITextViewSpellCheckingDelay];
 	}
 }
 
+- (void)_setMisspelled:(BOOL)misspelled inRange:(NSRange)range
+{
+	NSMutableAttributedString *backingStore = [renderer backingStore];
+	range = NSIntersectionRange(range, NSMakeRange(0, [backingStore length]));
+	if(misspelled) {
+		[backingStore addAttribute:NSUnderlineColorAttributeName value:[NSColor redColor] range:range];
+		[backingStore addAttribute:(id)kCTUnderlineStyleAttributeName value:[NSNumber numberWithInteger:kCTUnderlineStyleThick | kCTUnderlinePatternDot] range:range];
+	} else {
+		[backingStore removeAttribute:NSUnderlineColorAttributeName range:range];
+		[backingStore removeAttribute:(id)kCTUnderlineStyleAttributeName range:range];
+	}
+}
+
+// Called by the editor after it changes the backing store, before the renderer
+// hears about it. range holds the new characters.
+- (void)_updateSpellCheckingForChangeInRange:(NSRange)range changeInLength:(NSInteger)delta
+{
+	textGeneration++;
+	NSUInteger oldEnd = NSMaxRange(range) - delta;
+	
+	// misspellings after the edit move with their text, ones it touched wait to be checked again
+	NSMutableArray *results = [NSMutableArray arrayWithCapacity:[lastCheckResults count]];
+	for(NSTextCheckingResult *result in lastCheckResults) {
+		NSRange r = result.range;
+		if(NSMaxRange(r) < range.location) {
+			[results addObject:result];
+		} else if(r.location > oldEnd) {
+			[results addObject:[NSTextCheckingResult spellCheckingResultWithRange:NSMakeRange(r.location + delta, r.length)]];
+		} else {
+			NSUInteger start = MIN(r.location, range.location);
+			NSUInteger end = MAX((NSInteger)NSMaxRange(r) + delta, (NSInteger)NSMaxRange(range));
+			[self _setMisspelled:NO inRange:NSMakeRange(start, end - start)];
+		}
+	}
+	self.lastCheckResults = results;
+	
+	if(spellCheckRange.location != NSNotFound) {
+		NSUInteger start = spellCheckRange.location;
+		NSUInteger end = NSMaxRange(spellCheckRange);
+		start = (start <= range.location) ? start : ((start >= oldEnd) ? start + delta : range.location);
+		end = (end <= range.location) ? end : ((end >= oldEnd) ? end + delta : NSMaxRange(range));
+		spellCheckRange = NSUnionRange(NSMakeRange(start, end - start), range);
+	} else {
+		spellCheckRange = range;
+	}
+}
+
+- (void)_resetSpellChecking
+{
+	textGeneration++;
+	self.lastCheckResults = nil;
+	spellCheckRange = NSMakeRange(0, [[renderer backingStore] length]);
+}
+
+// Replaces text on behalf of the spell checker, laying out again only what changed.
+- (void)_replaceCharactersInRange:(NSRange)range withString:(NSString *)replacement
+{
+	NSRange selection = [self selectedRange];
+	NSMutableAttributedString *backingStore = [renderer backingStore];
+	[backingStore beginEditing];
+	// the replacement keeps the attributes of the word it replaces, less the misspelling underline
+	[self _setMisspelled:NO inRange:range];
+	[backingStore replaceCharactersInRange:range withString:replacement];
+	[backingStore endEditing];
+	
+	// the editor keeps its secure string and input context in step, moves the misspellings along and tells us the text changed
+	NSRange newRange = NSMakeRange(range.location, [replacement length]);
+	NSInteger lengthChange = (NSInteger)[replacement length] - (NSInteger)range.length;
+	[renderer _textDidChangeInRange:newRange changeInLength:lengthChange];
+	
+	// the replacement could have changed the length of the string, so adjust the selection to account for that
+	if(selection.location >= NSMaxRange(range))
+		[self setSelectedRange:NSMakeRange(selection.location + lengthChange, selection.length)];
+}
+
+// Checks the paragraphs edited since the last check.
 - (void)_checkSpelling
 {
+	if(spellCheckRange.location == NSNotFound)
+		return;
+	
+	NSString *text = [self.text copy];
+	NSUInteger start = MIN(spellCheckRange.location, [text length]);
+	NSUInteger end = MIN(NSMaxRange(spellCheckRange), [text length]);
+	NSRange checkRange = [text paragraphRangeForRange:NSMakeRange(start, end - start)];
+	NSUInteger generation = textGeneration;
+	
 	NSTextCheckingType checkingTypes = NSTextCheckingTypeSpelling;
 	if(autocorrectionEnabled) checkingTypes |= NSTextCheckingTypeCorrection | NSTextCheckingTypeReplacement;
 	
-	NSRange wholeLineRange = NSMakeRange(0, [self.text length]);
-	lastCheckToken = [[NSSpellChecker sharedSpellChecker] requestCheckingOfString:self.text range:wholeLineRange types:checkingTypes options:nil inSpellDocumentWithTag:0 completionHandler:^(NSInteger sequenceNumber, NSArray *results, NSOrthography *orthography, NSInteger wordCount) {
-		NSRange selectionRange = [self selectedRange];
-		__block NSRange activeWordSubstringRange = NSMakeRange(0, 0);
-		[self.text enumerateSubstringsInRange:NSMakeRange(0, [self.text length]) options:NSStringEnumerationByWords | NSStringEnumerationSubstringNotRequired | NSStringEnumerationReverse | NSStringEnumerationLocalized usingBlock:^(NSString *substring, NSRange substringRange, NSRange enclosingRange, BOOL *stop) {
+	lastCheckToken = [[NSSpellChecker sharedSpellChecker] requestCheckingOfString:text range:checkRange types:checkingTypes options:nil inSpellDocumentWithTag:0 completionHandler:^(NSInteger sequenceNumber, NSArray *results, NSOrthography *orthography, NSInteger wordCount) {
+		// This needs to happen on the main thread so that the user doesn't enter more text while we're changing the attributed string.
+		dispatch_async(dispatch_get_main_queue(), ^{
+			// we only care about the most recent results, and only for the text they were asked for
+			if(sequenceNumber != lastCheckToken || generation != textGeneration) return;
+			
+			[self _applySpellingResults:results inRange:checkRange];
+		});
+	}];
+}
+
+- (void)_applySpellingResults:(NSArray *)results inRange:(NSRange)checkRange
+{
+	spellCheckRange = NSMakeRange(NSNotFound, 0);
+	
+	NSString *text = [renderer backingStore].string;
+	NSRange selectionRange = [self selectedRange];
+	__block NSRange activeWordSubstringRange = NSMakeRange(0, 0);
+	if(NSLocationInRange(selectionRange.location, checkRange) || selectionRange.location == NSMaxRange(checkRange)) {
+		[text enumerateSubstringsInRange:checkRange options:NSStringEnumerationByWords | NSStringEnumerationSubstringNotRequired | NSStringEnumerationReverse | NSStringEnumerationLocalized usingBlock:^(NSString *substring, NSRange substringRange, NSRange enclosingRange, BOOL *stop) {
 			if(selectionRange.location >= substringRange.location && selectionRange.location <= substringRange.location + substringRange.length) {
 				activeWordSubstringRange = substringRange;
 				*stop = YES;
 			}
 		}];
-		
-		// This needs to happen on the main thread so that the user doesn't enter more text while we're changing the attributed string.
-		dispatch_async(dispatch_get_main_queue(), ^{
-			// we only care about the most recent results, ignore anything older
-			if(sequenceNumber != lastCheckToken) return;
-			
-			if([self.lastCheckResults isEqualToArray:results]) return;
-			
-			[[renderer backingStore] beginEditing];
-			
-			NSRange wholeStringRange = NSMakeRange(0, [self.text length]);
-			[[renderer backingStore] removeAttribute:(id)kCTUnderlineColorAttributeName range:wholeStringRange];
-			[[renderer backingStore] removeAttribute:(id)kCTUnderlineStyleAttributeName range:wholeStringRange];
-			
-			NSMutableArray *autocorrectedResultsThisRound = [NSMutableArray array];
-			for(NSTextCheckingResult *result in results) {
-				// Don't check the word they're typing. It's just annoying.
-				BOOL isActiveWord = NSEqualRanges(result.range, activeWordSubstringRange);
-				if(selectionRange.length == 0) {
-					if(isActiveWord) continue;
-					
-					// Don't correct if it looks like they might be typing a contraction.
-					unichar lastCharacter = [[[renderer backingStore] string] characterAtIndex:self.selectedRange.location - 1];
-					if(lastCharacter == '\'') continue;
-				}
-				
-				if(result.resultType == NSTextCheckingTypeCorrection || result.resultType == NSTextCheckingTypeReplacement) {
-					NSString *backingString = [[renderer backingStore] string];
-					if(NSMaxRange(result.range) <= backingString.length) {
-						NSString *oldString = [backingString substringWithRange:result.range];
-						TUITextViewAutocorrectedPair *correctionPair = [[TUITextViewAutocorrectedPair alloc] init];
-						correctionPair.correctionResult = result;
-						correctionPair.originalString = oldString;
-						
-						// Don't redo corrections that the user undid.
-						if([self.autocorrectedResults objectForKey:correctionPair] != nil) continue;
-						
-						[[renderer backingStore] removeAttribute:(id)kCTUnderlineColorAttributeName range:result.range];
-						[[renderer backingStore] removeAttribute:(id)kCTUnderlineStyleAttributeName range:result.range];
-						
-						[self.autocorrectedResults setObject:oldString forKey:correctionPair];
-						[[renderer backingStore] replaceCharactersInRange:result.range withString:result.replacementString];
-						[autocorrectedResultsThisRound addObject:result];
-						
-						// the replacement could have changed the length of the string, so adjust the selection to account for that
-						NSInteger lengthChange = result.replacementString.length - oldString.length;
-						[self setSelectedRange:NSMakeRange(self.selectedRange.location + lengthChange, self.selectedRange.length)];
-					} else {
-						NSLog(@"Autocorrection result that's out of range: %@", result);
-					}
-				} else if(result.resultType == NSTextCheckingTypeSpelling) {
-					[[renderer backingStore] addAttribute:NSUnderlineColorAttributeName value:[NSColor redColor] range:result.range];
-					[[renderer backingStore] addAttribute:(id)kCTUnderlineStyleAttributeName value:[NSNumber numberWithInteger:kCTUnderlineStyleThick | kCTUnderlinePatternDot] range:result.range];
-				}
-			}
-			
-			[[renderer backingStore] endEditing];
-			[renderer reset]; // make sure we reset so that the renderer uses our new attributes
-			
-			[self setNeedsDisplay];
+	}
+	
+	NSMutableArray *misspellings = [NSMutableArray array];
+	NSMutableArray *corrections = [NSMutableArray array];
+	for(NSTextCheckingResult *result in results) {
+		// Don't check the word they're typing. It's just annoying.
+		if(selectionRange.length == 0) {
+			if(NSEqualRanges(result.range, activeWordSubstringRange)) continue;
 			
-			self.lastCheckResults = results;
-		});
-	}];
+			// Don't correct if it looks like they might be typing a contraction.
+			if(selectionRange.location > 0 && [text characterAtIndex:selectionRange.location - 1] == '\'') continue;
+		}
+		
+		if(NSMaxRange(result.range) > [text length]) {
+			NSLog(@"Spell checking result that's out of range: %@", result);
+		} else if(result.resultType == NSTextCheckingTypeCorrection || result.resultType == NSTextCheckingTypeReplacement) {
+			[corrections addObject:result];
+		} else if(result.resultType == NSTextCheckingTypeSpelling) {
+			[misspellings addObject:result];
+		}
+	}
+	
+	// Underline against what's underlined already, so unchanged misspellings
+	// keep their attributes and only paragraphs that changed are laid out again.
+	NSMutableArray *checkResults = [NSMutableArray arrayWithCapacity:[lastCheckResults count] + [misspellings count]];
+	NSMutableSet *staleRanges = [NSMutableSet set];
+	for(NSTextCheckingResult *result in lastCheckResults) {
+		if(NSLocationInRange(result.range.location, checkRange))
+			[staleRanges addObject:[NSValue valueWithRange:result.range]];
+		else
+			[checkResults addObject:result];
+	}
+	
+	NSRange changedRange = NSMakeRange(NSNotFound, 0);
+	[[renderer backingStore] beginEditing];
+	for(NSTextCheckingResult *result in misspellings) {
+		NSValue *range = [NSValue valueWithRange:result.range];
+		if([staleRanges containsObject:range]) {
+			[staleRanges removeObject:range];
+		} else {
+			[self _setMisspelled:YES inRange:result.range];
+			changedRange = (changedRange.location == NSNotFound) ? result.range : NSUnionRange(changedRange, result.range);
+		}
+		[checkResults addObject:result];
+	}
+	for(NSValue *range in staleRanges) {
+		[self _setMisspelled:NO inRange:[range rangeValue]];
+		changedRange = (changedRange.location == NSNotFound) ? [range rangeValue] : NSUnionRange(changedRange, [range rangeValue]);
+	}
+	[[renderer backingStore] endEditing];
+	self.lastCheckResults = checkResults;
+	
+	if(changedRange.location != NSNotFound) {
+		[renderer _attributedStringDidChangeInRange:changedRange changeInLength:0];
+		[self setNeedsDisplay];
+	}
+	
+	// last first, so the ranges of the ones before stay put
+	for(NSTextCheckingResult *result in [corrections reverseObjectEnumerator]) {
+		NSString *oldString = [[[renderer backingStore] string] substringWithRange:result.range];
+		TUITextViewAutocorrectedPair *correctionPair = [[TUITextViewAutocorrectedPair alloc] init];
+		correctionPair.correctionResult = result;
+		correctionPair.originalString = oldString;
+		
+		// Don't redo corrections that the user undid.
+		if([self.autocorrectedResults objectForKey:correctionPair] != nil) continue;
+		
+		[self.autocorrectedResults setObject:oldString forKey:correctionPair];
+		[self _replaceCharactersInRange:result.range withString:result.replacementString];
+	}
 }
 
 - (NSMenu *)menuForEvent:(NSEvent *)event
@@ -583,38 +704,14 @@ static CAAnimation *ThrobAnimation()
 
 - (void)_replaceMisspelledWord:(NSMenuItem *)menuItem
 {
-	NSString *oldString = [self.text substringWithRange:self.selectedTextCheckingResult.range];
-	NSString *replacement = [menuItem representedObject];
-	[[renderer backingStore] beginEditing];
-	[[renderer backingStore] removeAttribute:(id)kCTUnderlineColorAttributeName range:selectedTextCheckingResult.range];
-	[[renderer backingStore] removeAttribute:(id)kCTUnderlineStyleAttributeName range:selectedTextCheckingResult.range];
-	[[renderer backingStore] replaceCharactersInRange:self.selectedTextCheckingResult.range withString:replacement];
-	[[renderer backingStore] endEditing];
-	[renderer reset];
-	
-	NSInteger lengthChange = replacement.length - oldString.length;
-	[self setSelectedRange:NSMakeRange(self.selectedRange.location + lengthChange, self.selectedRange.length)];
-	
-	[self _textDidChange];
+	[self _replaceCharactersInRange:self.selectedTextCheckingResult.range withString:[menuItem representedObject]];
 	
 	self.selectedTextCheckingResult = nil;
 }
 
 - (void)_replaceAutocorrectedWord:(NSMenuItem *)menuItem
 {
-	NSString *oldString = [self.text substringWithRange:self.selectedTextCheckingResult.range];
-	NSString *replacement = [menuItem representedObject];
-	[[renderer backingStore] beginEditing];
-	[[renderer backingStore] removeAttribute:(id)kCTUnderlineColorAttributeName range:selectedTextCheckingResult.range];
-	[[renderer backingStore] removeAttribute:(id)kCTUnderlineStyleAttributeName range:selectedTextCheckingResult.range];
-	[[renderer backingStore] replaceCharactersInRange:self.selectedTextCheckingResult.range withString:replacement];
-	[[renderer backingStore] endEditing];
-	[renderer reset];
-	
-	NSInteger lengthChange = replacement.length - oldString.length;
-	[self setSelectedRange:NSMakeRange(self.selectedRange.location + lengthChange, self.selectedRange.length)];
-	
-	[self _textDidChange];
+	[self _replaceCharactersInRange:self.selectedTextCheckingResult.range withString:[menuItem representedObject]];
 	
 	self.selectedTextCheckingResult = nil;
 }
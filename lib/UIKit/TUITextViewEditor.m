@@ -9,6 +9,16 @@
 #import "TUITextViewEditor.h"
 #import "TUITextView.h"
 
+@interface TUITextEditor ()
+- (void)_textDidChange;
+- (void)_textDidChangeInRange:(NSRange)range changeInLength:(NSInteger)delta;
+@end
+
+@interface TUITextView ()
+- (void)_updateSpellCheckingForChangeInRange:(NSRange)range changeInLength:(NSInteger)delta;
+- (void)_resetSpellChecking;
+@end
+
 @implementation TUITextViewEditor
 
 - (TUITextView *)_textView
@@ -21,6 +31,19 @@
 	return [super doCommandBySelector:selector];
 }
 
+// let the text view know what to spell check, before it hears the text changed
+- (void)_textDidChange
+{
+	[[self _textView] _resetSpellChecking];
+	[super _textDidChange];
+}
+
+- (void)_textDidChangeInRange:(NSRange)range changeInLength:(NSInteger)delta
+{
+	[[self _textView] _updateSpellCheckingForChangeInRange:range changeInLength:delta];
+	[super _textDidChangeInRange:range changeInLength:delta];
+}
+
 - (BOOL)becomeFirstResponder
 {
 	self.selectedRange = NSMakeRange(self.text.length, 0);
@@ -19,6 +19,7 @@
 #import "TUINSWindow.h"
 #import "TUITextRenderer+Event.h"
 #import "TUIView+Private.h"
+#import "TUITextRenderer+Private.h"
 
 @implementation TUIView (Event)
 
@@ -28,6 +29,15 @@
 	return [self textRendererAtPoint:p];
 }
 
+- (void)_updateHoveredTextRenderersWithEvent:(NSEvent *)event
+{
+	if(_textRenderers) {
+		TUITextRenderer *hoveredRenderer = [self _textRendererForEvent:event];
+		for(TUITextRenderer *renderer in _textRenderers)
+			[renderer _updateHoveredActiveRangeWithEvent:(renderer == hoveredRenderer) ? event : nil];
+	}
+}
+
 - (void)mouseMoved:(NSEvent *)event
 {
 	[self.superview mouseMoved:event];
@@ -198,6 +208,9 @@
 
 - (void)mouseExited:(NSEvent *)event
 {
+	for(TUITextRenderer *renderer in _textRenderers)
+		[renderer _updateHoveredActiveRangeWithEvent:nil];
+	
 	if(self.superview != nil){
 		[self.superview mouseExited:event fromSubview:self];
 	}
@@ -26,8 +26,22 @@ typedef void (^TUIMouseDraggedHandler)(NSEvent *dragEvent);
 @property (nonatomic, copy) TUIMouseDraggedHandler dragHandler;
 
 - (TUITextRenderer *)textRendererAtPoint:(CGPoint)point;
+- (void)_updateHoveredTextRenderersWithEvent:(NSEvent *)event; // only for the view under the mouse, not the ones a move is forwarded to
 - (void)_updateLayerScaleFactor;
 
+// backing store buffers are pooled, see TUIRecycleGraphicsContextData()
+- (void)_releaseBackingStore;
+- (void)_discardBackingStore; // also drops the layer's contents, for views leaving the window
+- (void)_discardBackingStoreIfDetached; // and the subviews', unless back in a window
+
+// see drawsInTiles, call when the visible part of the view may have changed
+- (void)_updateVisibleTiles;
+
+// views that were offscreen when the scale factor changed redraw once they're visible
+- (void)_displayIfNeededAtNewScale;
+- (void)_stopWaitingToDisplayAtNewScale; // and the subviews', for views that are hidden or leave the window
+
 @end
 
 extern CGFloat TUICurrentContextScaleFactor(void);
+extern BOOL TUIViewWantsScrollUpdates(void); // any tiled views, or views waiting to redraw at a new scale
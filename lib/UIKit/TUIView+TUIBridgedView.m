@@ -138,6 +138,8 @@
 }
 
 - (void)ancestorDidLayout; {
+	[self _updateVisibleTiles];
+	[self _displayIfNeededAtNewScale];
 	[self.subviews makeObjectsPerformSelector:_cmd];
 }
 
@@ -157,9 +159,30 @@
 }
 
 - (void)didMoveFromTUINSView:(TUINSView *)view; {
+	// Offscreen views don't need to hold on to their pixels, but a view is
+	// often taken out and put straight back (e.g. -bringSubviewToFront:), so
+	// wait until the end of the run loop to see whether it stayed out. The
+	// root of the moved subtree checks for all of it.
+	TUIView *superview = self.superview;
+	if (superview == nil || superview.nsView != nil) {
+		[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(_discardBackingStoreIfDetached) object:nil];
+		if (self.nsView == nil) {
+			[self _stopWaitingToDisplayAtNewScale];
+			[self performSelector:@selector(_discardBackingStoreIfDetached) withObject:nil afterDelay:0 inModes:[NSArray arrayWithObject:NSRunLoopCommonModes]];
+		}
+	}
+
 	[self.subviews makeObjectsPerformSelector:_cmd withObject:view];
 }
 
+- (void)_discardBackingStoreIfDetached {
+	if (self.nsView != nil)
+		return;
+
+	[self _discardBackingStore];
+	[self.subviews makeObjectsPerformSelector:_cmd];
+}
+
 - (void)willMoveToTUINSView:(TUINSView *)view; {
 	[self.subviews makeObjectsPerformSelector:_cmd withObject:view];
 }
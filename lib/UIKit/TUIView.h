@@ -22,6 +22,12 @@ extern NSString * const TUIViewDidMoveToWindowNotification;
 extern NSString * const TUIViewWindow;
 extern NSString * const TUIViewFrameDidChangeNotification;
 
+// keys of -overdrawReport
+extern NSString * const TUIViewOverdrawAverageKey; // NSNumber, views drawn over each point on average
+extern NSString * const TUIViewOverdrawMaximumKey; // NSNumber, most views drawn over a single point
+extern NSString * const TUIViewOverdrawShouldBeOpaqueKey; // NSArray of views
+extern NSString * const TUIViewOverdrawOccludedKey; // NSArray of views
+
 enum {
 	TUIViewAutoresizingNone                 = 0,
 	TUIViewAutoresizingFlexibleLeftMargin   = 1 << 0,
@@ -66,6 +72,7 @@ typedef enum {
 @class TUIView;
 
 typedef void(^TUIViewDrawRect)(TUIView *, CGRect);
+typedef void(^TUIViewDrawInContext)(TUIView *, struct TUIDrawContext *); // see TUICGAdditions.h
 typedef CGRect(^TUIViewLayout)(TUIView *);
 
 extern CGRect(^TUIViewCenteredLayout)(TUIView*);
@@ -88,6 +95,13 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
 	__unsafe_unretained id<TUIViewDelegate> _viewDelegate;
 	
 	TUIViewDrawRect	drawRect;
+	TUIViewDrawInContext drawInContext;
+	id<NSObject, NSCopying> _renderCacheKey;
+	
+	// what was drawn for the other window keyedness, see needsDisplayWhenWindowsKeyednessChanges
+	id _otherKeyednessContents;
+	CGSize _otherKeyednessSize;
+	CGFloat _otherKeyednessScale;
 	TUIViewLayout		layout;
 	
 	NSString *toolTip;
@@ -100,9 +114,15 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
 		NSInteger lastWidth;
 		NSInteger lastHeight;
 		BOOL lastOpaque;
-		CGContextRef context;
-		CGRect dirtyRect;
+		CGContextRef context; // drawn into next
+		CFMutableDataRef data;
+		CGContextRef frontContext; // currently shown by the layer
+		CFMutableDataRef frontData;
+		CGRect dirtyRect; // CGRectZero means everything
+		CGRect frontDirtyRect; // changed by the last draw, so stale in context
 		CGFloat lastContentsScale;
+		BOOL needsFullRedraw; // context is new, nothing in it to keep
+		volatile int32_t generation; // background draws of older generations are dropped
 	} _context;
 	
 	struct {
@@ -118,6 +138,9 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
 		unsigned int clearsContextBeforeDrawing:1;
 		unsigned int drawInBackground:1;
 		unsigned int needsDisplayWhenWindowsKeyednessChanges:1;
+		unsigned int drawsInTiles:1;
+		unsigned int skippedDrawingWhileOccluded:1;
+		unsigned int needsDisplayAtNewScale:1;
 		
 		unsigned int delegateMouseEntered:1;
 		unsigned int delegateMouseExited:1;
@@ -131,6 +154,12 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
 	TUIAccessibilityTraits accessibilityTraits;
 	CGRect accessibilityFrame;
 	NSOperationQueue *drawQueue;
+	NSOperation *_drawOperation;
+	
+	CALayer *_tileLayer;
+	NSMutableDictionary *_tiles;
+	NSMutableArray *_tileUsage; // tile keys, least recently visible first
+	CGSize _tileSize;
 }
 
 /**
@@ -188,7 +217,7 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
 @property (nonatomic, assign) TUIViewContentMode contentMode;
 
 /**
- If YES, drawing will be done in a background queue. If `drawQueue` is nil, it will be performed in the DISPATCH_QUEUE_PRIORITY_DEFAULT global queue. Note that `-viewWillDisplayLayer:` will still be called on the main thread.
+ If YES, drawing will be done in a background queue. If `drawQueue` is nil, it will be performed in a shared queue that runs as many draws at once as there are processor cores, drawing visible views first. A draw that hasn't finished when the view needs display again is dropped, and finished draws are shown together in one transaction. Note that `-viewWillDisplayLayer:` will still be called on the main thread.
  
  Defaults to NO.
  */
@@ -217,7 +246,7 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
 - (void)windowDidResignKey;
 
 /**
- * Does this view need to be redisplayed when the view's window's keyedness changes? If YES, the view will get automatically marked as needing display when the window's keyedness changes. Defaults to NO.
+ * Does this view need to be redisplayed when the view's window's keyedness changes? If YES, the view will get automatically marked as needing display when the window's keyedness changes. What was drawn for the previous keyedness is kept, so when the window changes back the view can show it again without drawing, unless it's been marked as needing display since. Defaults to NO.
  */
 @property (nonatomic, assign) BOOL needsDisplayWhenWindowsKeyednessChanges;
 
@@ -342,6 +371,11 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
  */
 @property (nonatomic, copy) TUIViewDrawRect drawRect;
 
+/**
+ Like drawRect, but handed the whole draw context: the CGContext, scale factor, dirty rect and quality hints, so it doesn't need to look any of them up. Used instead of drawRect and -drawRect: when set.
+ */
+@property (nonatomic, copy) TUIViewDrawInContext drawInContext;
+
 /**
  Forces an immediate update of the backing view's layer.contents. May be inside an animation block to cross-fade.
  */
@@ -394,6 +428,53 @@ extern CGRect(^TUIViewCenteredLayout)(TUIView*);
  */
 @property (nonatomic) BOOL clearsContextBeforeDrawing;
 
+/**
+ If YES, the view draws its content in tiles of `tileSize`, and only the tiles that are visible are drawn and kept around, instead of a single bitmap the size of the view's bounds. Use this for very large views, like a long document in a scroll view. Tiles are drawn in the background if `drawInBackground` is YES.
+ 
+ Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL drawsInTiles;
+
+/**
+ The size of the tiles, in points, used when `drawsInTiles` is YES.
+ 
+ Defaults to 256x256.
+ */
+@property (nonatomic, assign) CGSize tileSize;
+
+/**
+ Identifies what the view draws, for views that repeat the same drawing many times over, like an avatar or a badge in every cell of a table. Views with equal keys, bounds sizes, scale factors and opacity share one rendered bitmap: the first one to display draws it, the rest reuse it without calling -drawRect:. Only use it if drawing depends on nothing but the key and the view's size.
+ 
+ Defaults to nil (always draw).
+ */
+@property (nonatomic, copy) id<NSObject, NSCopying> renderCacheKey;
+
+/**
+ Limits the memory used by bitmaps shared through `renderCacheKey`. The least recently used are dropped first. Defaults to 32MB.
+ */
++ (void)setRenderCacheByteLimit:(NSUInteger)limit;
+
+/**
+ How many displays were served from the render cache, and how many had to draw, since launch.
+ */
++ (NSUInteger)renderCacheHitCount;
++ (NSUInteger)renderCacheMissCount;
+
+/**
+ If YES, views completely covered by an opaque sibling in front of them don't draw until they're uncovered. Turning it off again doesn't redraw views that were skipped, use -setEverythingNeedsDisplay for that.
+ 
+ Transformed siblings never count as covering. Changes made through the view's own properties (frame, bounds, transform, alpha, opaque, hidden) are noticed, changes made directly to its layer aren't.
+ 
+ Defaults to NO.
+ */
++ (void)setSkipsDrawingOccludedViews:(BOOL)skips;
++ (BOOL)skipsDrawingOccludedViews;
+
+/**
+ A debugging aid. Looks at the visible part of the receiver and its subviews and reports how many views are drawn over each point on average and at most, views that fill themselves with an opaque background color but aren't marked opaque, and views that draw but are completely covered by opaque views in front of them. See the TUIViewOverdraw keys.
+ */
+- (NSDictionary *)overdrawReport;
+
 @end
 
 @interface TUIView (TUIViewAnimation)
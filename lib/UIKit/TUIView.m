@@ -14,7 +14,7 @@
  limitations under the License.
  */
 
-#import <pthread.h>
+#import <libkern/OSAtomic.h>
 #import "NSColor+TUIExtensions.h"
 #import "TUICGAdditions.h"
 #import "TUIView.h"
@@ -32,10 +32,20 @@
  */
 #define CA_COLOR_OVERLAY_DEBUG 0
 
+// see drawsInTiles
+#define TUIViewDefaultTileSize 256.0
+#define TUIViewMaximumOffscreenTiles 16
+
 NSString * const TUIViewWillMoveToWindowNotification = @"TUIViewWillMoveToWindowNotification";
 NSString * const TUIViewDidMoveToWindowNotification = @"TUIViewDidMoveToWindowNotification";
 NSString * const TUIViewWindow = @"TUIViewWindow";
 NSString * const TUIViewFrameDidChangeNotification = @"TUIViewFrameDidChangeNotification";
+NSString * const TUIViewOverdrawAverageKey = @"TUIViewOverdrawAverageKey";
+NSString * const TUIViewOverdrawMaximumKey = @"TUIViewOverdrawMaximumKey";
+NSString * const TUIViewOverdrawShouldBeOpaqueKey = @"TUIViewOverdrawShouldBeOpaqueKey";
+NSString * const TUIViewOverdrawOccludedKey = @"TUIViewOverdrawOccludedKey";
+
+static BOOL TUIViewSkipsDrawingOccludedViews = NO;
 
 CGRect(^TUIViewCenteredLayout)(TUIView*) = nil;
 
@@ -68,6 +78,99 @@ CGRect(^TUIViewCenteredLayout)(TUIView*) = nil;
 
 @end
 
+/*
+ Render cache, see renderCacheKey. Only used on the main thread.
+ */
+@interface TUIViewRenderCacheKey : NSObject <NSCopying>
+@property (nonatomic, strong) id<NSObject, NSCopying> key;
+@property (nonatomic, assign) CGSize size;
+@property (nonatomic, assign) CGFloat scale;
+@property (nonatomic, assign) BOOL opaque;
+@end
+
+@implementation TUIViewRenderCacheKey
+
+- (id)copyWithZone:(NSZone *)zone
+{
+	return self; // never changed once it's made
+}
+
+- (NSUInteger)hash
+{
+	return [self.key hash] ^ ((NSUInteger)self.size.width << 16) ^ (NSUInteger)self.size.height ^ ((NSUInteger)self.scale << 8) ^ self.opaque;
+}
+
+- (BOOL)isEqual:(id)object
+{
+	if(![object isKindOfClass:[TUIViewRenderCacheKey class]])
+		return NO;
+	TUIViewRenderCacheKey *other = object;
+	return CGSizeEqualToSize(self.size, other.size) && self.scale == other.scale && self.opaque == other.opaque && [self.key isEqual:other.key];
+}
+
+@end
+
+@interface TUIViewRenderCacheEntry : NSObject
+@property (nonatomic, strong) id image; // CGImageRef
+@property (nonatomic, assign) NSUInteger bytes;
+@property (nonatomic, assign) NSUInteger lastUse;
+@end
+
+@implementation TUIViewRenderCacheEntry
+@end
+
+static NSMutableDictionary *TUIViewRenderCache = nil;
+static NSUInteger TUIViewRenderCacheBytes = 0;
+static NSUInteger TUIViewRenderCacheByteLimit = 32 * 1024 * 1024;
+static NSUInteger TUIViewRenderCacheClock = 0;
+static NSUInteger TUIViewRenderCacheHits = 0;
+static NSUInteger TUIViewRenderCacheMisses = 0;
+
+static void TUIViewTrimRenderCache(NSUInteger limit)
+{
+	if(TUIViewRenderCacheBytes <= limit)
+		return;
+	
+	// drop down to three quarters of the limit so we don't do this on every insert
+	NSArray *keys = [TUIViewRenderCache keysSortedByValueUsingComparator:^NSComparisonResult(TUIViewRenderCacheEntry *a, TUIViewRenderCacheEntry *b) {
+		return a.lastUse < b.lastUse ? NSOrderedAscending : (a.lastUse > b.lastUse ? NSOrderedDescending : NSOrderedSame);
+	}];
+	for(TUIViewRenderCacheKey *key in keys) {
+		if(TUIViewRenderCacheBytes <= limit / 4 * 3)
+			break;
+		TUIViewRenderCacheBytes -= [[TUIViewRenderCache objectForKey:key] bytes];
+		[TUIViewRenderCache removeObjectForKey:key];
+	}
+}
+
+static CGImageRef TUIViewRenderCacheGetImage(TUIViewRenderCacheKey *key)
+{
+	TUIViewRenderCacheEntry *entry = [TUIViewRenderCache objectForKey:key];
+	if(!entry) {
+		TUIViewRenderCacheMisses++;
+		return NULL;
+	}
+	TUIViewRenderCacheHits++;
+	entry.lastUse = ++TUIViewRenderCacheClock;
+	return (__bridge CGImageRef)entry.image;
+}
+
+static void TUIViewRenderCacheSetImage(TUIViewRenderCacheKey *key, CGImageRef image)
+{
+	if(!TUIViewRenderCache)
+		TUIViewRenderCache = [[NSMutableDictionary alloc] init];
+	
+	TUIViewRenderCacheEntry *entry = [[TUIViewRenderCacheEntry alloc] init];
+	entry.image = (__bridge id)image;
+	entry.bytes = CGImageGetBytesPerRow(image) * CGImageGetHeight(image);
+	entry.lastUse = ++TUIViewRenderCacheClock;
+	
+	TUIViewRenderCacheBytes -= [[TUIViewRenderCache objectForKey:key] bytes];
+	[TUIViewRenderCache setObject:entry forKey:key];
+	TUIViewRenderCacheBytes += entry.bytes;
+	TUIViewTrimRenderCache(TUIViewRenderCacheByteLimit);
+}
+
 
 @interface TUIView ()
 @property (nonatomic, strong) NSMutableArray *subviews;
@@ -78,6 +181,11 @@ CGRect(^TUIViewCenteredLayout)(TUIView*) = nil;
  * layer.
  */
 - (void)prepareSubview:(TUIView *)view insertionBlock:(void (^)(void))block;
+
+- (void)_removeAllTiles;
+- (BOOL)_hasDrawRect;
+- (void)_subviewGeometryDidChange;
+- (CGRect)_visibleRect;
 @end
 
 @implementation TUIView
@@ -103,13 +211,63 @@ CGRect(^TUIViewCenteredLayout)(TUIView*) = nil;
 	}
 }
 
-static pthread_key_t TUICurrentContextScaleFactorTLSKey;
+static NSUInteger TUIViewTiledViewCount = 0;
+static NSUInteger TUIViewPendingRescaleCount = 0;
+
+BOOL TUIViewWantsScrollUpdates(void)
+{
+	return TUIViewTiledViewCount > 0 || TUIViewPendingRescaleCount > 0;
+}
+
+/*
+ Background drawing. Draws run in a shared queue, one per processor core at a
+ time, and their results are handed back to the main thread where everything
+ that finished since the last pass is shown in a single transaction.
+ */
+static NSOperationQueue *TUIViewSharedDrawQueue(void)
+{
+	static NSOperationQueue *queue = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		queue = [[NSOperationQueue alloc] init];
+		queue.name = @"com.twitter.TwUI.draw";
+		queue.maxConcurrentOperationCount = [[NSProcessInfo processInfo] activeProcessorCount];
+	});
+	return queue;
+}
+
+static OSSpinLock TUIViewDrawResultsLock = OS_SPINLOCK_INIT;
+static NSMutableArray *TUIViewDrawResults = nil;
+
+static void TUIViewPublishDrawResult(void (^block)(void))
+{
+	OSSpinLockLock(&TUIViewDrawResultsLock);
+	BOOL scheduled = (TUIViewDrawResults != nil);
+	if(!scheduled)
+		TUIViewDrawResults = [[NSMutableArray alloc] init];
+	[TUIViewDrawResults addObject:[block copy]];
+	OSSpinLockUnlock(&TUIViewDrawResultsLock);
+	
+	if(scheduled)
+		return;
+	
+	dispatch_async(dispatch_get_main_queue(), ^{
+		OSSpinLockLock(&TUIViewDrawResultsLock);
+		NSArray *results = TUIViewDrawResults;
+		TUIViewDrawResults = nil;
+		OSSpinLockUnlock(&TUIViewDrawResultsLock);
+		
+		[CATransaction begin];
+		for(void (^result)(void) in results) {
+			result();
+		}
+		[CATransaction commit];
+	});
+}
 
 + (void)initialize
 {
 	if(self == [TUIView class]) {
-		pthread_key_create(&TUICurrentContextScaleFactorTLSKey, free);
-
 		TUIViewCenteredLayout = [^(TUIView *v) {
 			TUIView *superview = v.superview;
 			CGRect b = superview.frame;
@@ -133,13 +291,12 @@ static pthread_key_t TUICurrentContextScaleFactorTLSKey;
 	[[TUILayoutManager sharedLayoutManager] setLayoutName:nil forView:self];
 
 	if (self.nsView.trackingView == self) self.nsView.trackingView = nil;
+	if (_viewFlags.drawsInTiles) TUIViewTiledViewCount--;
+	if (_viewFlags.needsDisplayAtNewScale) TUIViewPendingRescaleCount--;
     
 	[self setTextRenderers:nil];
 	_layer.delegate = nil;
-	if(_context.context) {
-		CGContextRelease(_context.context);
-		_context.context = NULL;
-	}
+	[self _releaseBackingStore];
 }
 
 - (id)initWithFrame:(CGRect)frame
@@ -236,10 +393,47 @@ static pthread_key_t TUICurrentContextScaleFactorTLSKey;
 	_viewFlags.needsDisplayWhenWindowsKeyednessChanges = needsDisplay;
 }
 
+/*
+ Keep what's shown now for when the window changes back, and show what was
+ kept from last time if it's still good, otherwise draw.
+ */
+- (void)_windowKeyednessDidChange
+{
+	if(_viewFlags.drawsInTiles || self.layer.contents == nil) {
+		[self setNeedsDisplay];
+		return;
+	}
+	
+	CGSize size = self.bounds.size;
+	CGFloat scale = [self.layer respondsToSelector:@selector(contentsScale)] ? self.layer.contentsScale : 1.0f;
+	id contents = self.layer.contents;
+	id otherContents = _otherKeyednessContents;
+	BOOL otherContentsValid = otherContents != nil && CGSizeEqualToSize(size, _otherKeyednessSize) && scale == _otherKeyednessScale && ![self.layer needsDisplay];
+	
+	// the contents share the front buffer, hand it over to them instead of drawing into it again
+	if(_context.frontContext) {
+		CGContextRelease(_context.frontContext);
+		CFRelease(_context.frontData);
+		_context.frontContext = NULL;
+		_context.frontData = NULL;
+	}
+	[self _releaseBackingStore];
+	
+	if(otherContentsValid) {
+		self.layer.contents = otherContents;
+	} else {
+		[self setNeedsDisplay];
+	}
+	
+	_otherKeyednessContents = contents;
+	_otherKeyednessSize = size;
+	_otherKeyednessScale = scale;
+}
+
 - (void)windowDidBecomeKey
 {
 	if(self.needsDisplayWhenWindowsKeyednessChanges)
-		[self setNeedsDisplay];
+		[self _windowKeyednessDidChange];
 	
 	[self.subviews makeObjectsPerformSelector:@selector(windowDidBecomeKey)];
 }
@@ -247,7 +441,7 @@ static pthread_key_t TUICurrentContextScaleFactorTLSKey;
 - (void)windowDidResignKey
 {
 	if(self.needsDisplayWhenWindowsKeyednessChanges)
-		[self setNeedsDisplay];
+		[self _windowKeyednessDidChange];
 	
 	[self.subviews makeObjectsPerformSelector:@selector(windowDidResignKey)];
 }
@@ -276,6 +470,48 @@ static pthread_key_t TUICurrentContextScaleFactorTLSKey;
 	return NO;
 }
 
+- (void)_releaseBackingStore
+{
+	if(_context.context) {
+		CGContextRelease(_context.context);
+		TUIRecycleGraphicsContextData(_context.data);
+		CFRelease(_context.data);
+		_context.context = NULL;
+		_context.data = NULL;
+	}
+	if(_context.frontContext) {
+		CGContextRelease(_context.frontContext);
+		TUIRecycleGraphicsContextData(_context.frontData);
+		CFRelease(_context.frontData);
+		_context.frontContext = NULL;
+		_context.frontData = NULL;
+	}
+}
+
+- (void)_discardBackingStore
+{
+	if(_tiles.count > 0) {
+		[self _removeAllTiles];
+		[self setNeedsDisplay];
+	}
+	
+	if(!_context.context && !_context.frontContext)
+		return;
+	
+	// the layer's contents share the front buffer, let go of them so it can be reused
+	[self _releaseBackingStore];
+	self.layer.contents = nil;
+	[self setNeedsDisplay];
+}
+
+/*
+ The backing store is double buffered. The layer shows an image sharing the
+ memory of the front context while we draw into the other one, and the two
+ swap after each draw (see -_swapBackingStore), so publishing a draw doesn't
+ copy the bitmap. The images are copy on write: a buffer whose image from two
+ draws ago is still held (read from layer.contents, in a transition, not
+ rendered yet) goes back to the pool and is replaced instead of drawn into.
+ */
 - (CGContextRef)_CGContext
 {
 	CGRect b = self.bounds;
@@ -284,18 +520,25 @@ static pthread_key_t TUICurrentContextScaleFactorTLSKey;
 	BOOL o = self.opaque;
 	CGFloat currentScale = [self.layer respondsToSelector:@selector(contentsScale)] ? self.layer.contentsScale : 1.0f;
 	
-	if(_context.context) {
+	if(_context.context || _context.frontContext) {
 		// kill if we're a different size
 		if(w != _context.lastWidth || 
 		   h != _context.lastHeight ||
 		   o != _context.lastOpaque ||
 		   fabs(currentScale - _context.lastContentsScale) > 0.1f) 
 		{
-			CGContextRelease(_context.context);
-			_context.context = NULL;
+			[self _releaseBackingStore];
 		}
 	}
 	
+	if(_context.context && TUIGraphicsContextDataIsInUse(_context.data)) {
+		CGContextRelease(_context.context);
+		TUIRecycleGraphicsContextData(_context.data); // it joins the pool once the image is gone
+		CFRelease(_context.data);
+		_context.context = NULL;
+		_context.data = NULL;
+	}
+	
 	if(!_context.context) {
 		// create a new context with the correct parameters
 		_context.lastWidth = w;
@@ -307,80 +550,169 @@ static pthread_key_t TUICurrentContextScaleFactorTLSKey;
 		b.size.height *= currentScale;
 		if(b.size.width < 1) b.size.width = 1;
 		if(b.size.height < 1) b.size.height = 1;
-		CGContextRef ctx = TUICreateGraphicsContextWithOptions(b.size, o);
-		_context.context = ctx;
+		_context.context = TUICreateGraphicsContextWithData(b.size, o, &_context.data);
+		_context.needsFullRedraw = YES;
 	}
 	
 	return _context.context;
 }
 
+/*
+ Show what was just drawn into the back buffer, and make the old front buffer
+ the one drawn into next. It's missing whatever changed in this draw.
+ */
+- (void)_swapBackingStoreWithChangedRect:(CGRect)changedRect
+{
+	if(!_context.context)
+		return;
+	
+	CGImageRef image = TUICreateCGImageWithBitmapContextData(_context.context, _context.data);
+	self.layer.contents = (__bridge id)image;
+	CGImageRelease(image);
+	
+	CGContextRef context = _context.frontContext;
+	CFMutableDataRef data = _context.frontData;
+	_context.frontContext = _context.context;
+	_context.frontData = _context.data;
+	_context.context = context;
+	_context.data = data;
+	_context.frontDirtyRect = changedRect;
+}
+
 CGFloat TUICurrentContextScaleFactor(void)
 {
 	/*
-	 Key is set up in +initialize
-	 Use TLS rather than a simple global so drawsInBackground should continue to work (views in the same process may be drawing destined for different windows on different screens with different scale factors).
+	 Per thread rather than a simple global so drawsInBackground should continue to work (views in the same process may be drawing destined for different windows on different screens with different scale factors).
 	 */
-	CGFloat *v = pthread_getspecific(TUICurrentContextScaleFactorTLSKey);
-	if(v)
-		return *v;
+	TUIDrawContext *drawContext = TUIGraphicsGetCurrentDrawContext();
+	if(drawContext)
+		return drawContext->scale;
 	return 1.0;
 }
 
-static void TUISetCurrentContextScaleFactor(CGFloat s)
+- (BOOL)_hasDrawRect
 {
-	CGFloat *v = pthread_getspecific(TUICurrentContextScaleFactorTLSKey);
-	if(!v) {
-		v = malloc(sizeof(CGFloat));
-		pthread_setspecific(TUICurrentContextScaleFactorTLSKey, v);
+	if (self.drawRect || self.drawInContext)
+		return YES;
+
+	SEL drawRectSEL = @selector(drawRect:);
+	return [self methodForSelector:drawRectSEL] != [TUIView instanceMethodForSelector:drawRectSEL] && ![self _disableDrawRect];
+}
+
+// only looks at siblings, see +skipsDrawingOccludedViews
+- (BOOL)_isCoveredByOpaqueSibling
+{
+	TUIView *superview = self.superview;
+	if (!superview)
+		return NO;
+
+	// siblings in front have a higher zPosition, or the same one and come later (see -sortedSubviews)
+	CGRect f = self.frame;
+	CGFloat z = self.layer.zPosition;
+	NSArray *siblings = superview.subviews;
+	NSUInteger index = [siblings indexOfObjectIdenticalTo:self];
+	for (NSUInteger i = 0; i < siblings.count; ++i) {
+		TUIView *sibling = [siblings objectAtIndex:i];
+		CGFloat siblingZ = sibling.layer.zPosition;
+		if (siblingZ < z || (siblingZ == z && i <= index))
+			continue;
+		if (sibling.opaque && !sibling.hidden && sibling.alpha >= 1.0 &&
+			CATransform3DIsIdentity(sibling.layer.transform) && CGRectContainsRect(sibling.frame, f))
+			return YES;
 	}
-	*v = s;
+	return NO;
 }
 
-- (void)displayLayer:(CALayer *)layer
+- (void)_subviewGeometryDidChange
 {
-	typedef void (*DrawRectIMP)(id,SEL,CGRect);
-	SEL drawRectSEL = @selector(drawRect:);
-	DrawRectIMP drawRectIMP = (DrawRectIMP)[self methodForSelector:drawRectSEL];
-	DrawRectIMP dontCallThisBasicDrawRectIMP = (DrawRectIMP)[TUIView instanceMethodForSelector:drawRectSEL];
+	if (!TUIViewSkipsDrawingOccludedViews)
+		return;
 
-	if (!self.drawRect && (drawRectIMP == dontCallThisBasicDrawRectIMP || [self _disableDrawRect])) {
+	for (TUIView *subview in self.subviews) {
+		if (subview->_viewFlags.skippedDrawingWhileOccluded && ![subview _isCoveredByOpaqueSibling]) {
+			subview->_viewFlags.skippedDrawingWhileOccluded = 0;
+			[subview setNeedsDisplay];
+		}
+	}
+}
+
+- (void)displayLayer:(CALayer *)layer
+{
+	if (![self _hasDrawRect]) {
 		// drawRect isn't overridden by subclass, don't call, let the CA machinery just handle backgroundColor (fast path)
 		return;
 	}
 
+	if (_viewFlags.needsDisplayAtNewScale) {
+		// whatever the reason for this draw, it'll be at the current scale
+		_viewFlags.needsDisplayAtNewScale = 0;
+		TUIViewPendingRescaleCount--;
+	}
+
+	if (TUIViewSkipsDrawingOccludedViews && [self _isCoveredByOpaqueSibling]) {
+		// nobody would see it, draw once we're uncovered (see -_subviewGeometryDidChange)
+		_viewFlags.skippedDrawingWhileOccluded = 1;
+		return;
+	}
+
+	if (_viewFlags.drawsInTiles || self.drawInBackground) {
+		// scheduling is done on the main thread, drawing may not be
+		void (^scheduleBlock)(void) = ^{
+			if (_viewFlags.drawsInTiles) {
+				[self _displayTiles];
+			} else {
+				[self _scheduleBackgroundDisplay];
+			}
+		};
+		if ([NSThread isMainThread]) {
+			scheduleBlock();
+		} else {
+			dispatch_async(dispatch_get_main_queue(), scheduleBlock);
+		}
+		return;
+	}
+
 	void (^drawBlock)(void) = ^{
 		if (_viewFlags.delegateWillDisplayLayer) {
 			[_viewDelegate viewWillDisplayLayer:self];
 		}
 
-		CGRect rectToDraw = self.bounds;
-		if (!CGRectEqualToRect(_context.dirtyRect, CGRectZero)) {
-			rectToDraw = _context.dirtyRect;
-			_context.dirtyRect = CGRectZero;
+		if (_renderCacheKey != nil) {
+			[self _displayFromRenderCache];
+			return;
 		}
 
 		CGContextRef context = [self _CGContext];
-		TUIGraphicsPushContext(context);
 
-		CGFloat scale = [self.layer respondsToSelector:@selector(contentsScale)] ? self.layer.contentsScale : 1.0f;
-		TUISetCurrentContextScaleFactor(scale);
-		CGContextScaleCTM(context, scale, scale);
+		// The back buffer keeps what was drawn into it two draws ago, so only
+		// the dirty region and whatever changed in the last draw need to be
+		// drawn again.
+		CGRect changedRect = self.bounds;
+		if (!CGRectEqualToRect(_context.dirtyRect, CGRectZero)) {
+			changedRect = CGRectIntersection(CGRectIntegral(_context.dirtyRect), changedRect);
+		}
+		CGRect rectToDraw = self.bounds;
+		if (!_context.needsFullRedraw) {
+			rectToDraw = CGRectIntersection(CGRectUnion(changedRect, _context.frontDirtyRect), rectToDraw);
+		}
+		_context.dirtyRect = CGRectZero;
+		_context.needsFullRedraw = NO;
+
+		CGContextSaveGState(context);
+
+		TUIDrawContext drawContext = {
+			.context = context,
+			.scale = [self.layer respondsToSelector:@selector(contentsScale)] ? self.layer.contentsScale : 1.0f,
+			.dirtyRect = rectToDraw,
+		};
+		CGContextScaleCTM(context, drawContext.scale, drawContext.scale);
+		CGContextClipToRect(context, rectToDraw);
 
 		if (_viewFlags.clearsContextBeforeDrawing) {
 			CGContextClearRect(context, rectToDraw);
 		}
 
-		CGContextSetAllowsAntialiasing(context, true);
-		CGContextSetShouldAntialias(context, true);
-		CGContextSetShouldSmoothFonts(context, !_viewFlags.disableSubpixelTextRendering);
-
-		if (self.drawRect) {
-			// drawRect is implemented via a block
-			self.drawRect(self, rectToDraw);
-		} else if ((drawRectIMP != dontCallThisBasicDrawRectIMP) && ![self _disableDrawRect]) {
-			// drawRect is overridden by subclass
-			drawRectIMP(self, drawRectSEL, rectToDraw);
-		}
+		[self _drawInDrawContext:&drawContext];
 
 		#if CA_COLOR_OVERLAY_DEBUG
 		if (self.opaque) {
@@ -391,22 +723,11 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 		CGContextFillRect(context, rectToDraw);
 		#endif
 
-		layer.contents = TUIGraphicsGetImageFromCurrentImageContext();
-		CGContextScaleCTM(context, 1.0f / scale, 1.0f / scale);
-		TUIGraphicsPopContext();
-
-		if (self.drawInBackground) [CATransaction flush];
+		CGContextRestoreGState(context);
+		[self _swapBackingStoreWithChangedRect:changedRect];
 	};
 	
-	if (self.drawInBackground) {
-		layer.contents = nil;
-		
-		if (self.drawQueue != nil) {
-			[self.drawQueue addOperationWithBlock:drawBlock];
-		} else {
-			dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), drawBlock);
-		}
-	} else if ([NSThread isMainThread] || dispatch_get_current_queue() == dispatch_get_main_queue()) {
+	if ([NSThread isMainThread] || dispatch_get_current_queue() == dispatch_get_main_queue()) {
 		drawBlock();
 	} else {
 		// On Mac OS X 10.6 (and possibly other versions), spinning a run loop in
@@ -416,6 +737,341 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 	}
 }
 
+// only called from -displayLayer: once it's known there's something to draw,
+// drawContext's context is already scaled and clipped to its dirty rect
+- (void)_drawInDrawContext:(TUIDrawContext *)drawContext
+{
+	drawContext->shouldAntialias = YES;
+	drawContext->shouldSmoothFonts = !_viewFlags.disableSubpixelTextRendering;
+	drawContext->interpolationQuality = kCGInterpolationDefault;
+
+	CGContextRef context = drawContext->context;
+	CGContextSetAllowsAntialiasing(context, true);
+	CGContextSetShouldAntialias(context, drawContext->shouldAntialias);
+	CGContextSetShouldSmoothFonts(context, drawContext->shouldSmoothFonts);
+	CGContextSetInterpolationQuality(context, drawContext->interpolationQuality);
+
+	TUIGraphicsPushDrawContext(drawContext);
+	if (self.drawInContext) {
+		self.drawInContext(self, drawContext);
+	} else if (self.drawRect) {
+		// drawRect is implemented via a block
+		self.drawRect(self, drawContext->dirtyRect);
+	} else {
+		// drawRect is overridden by subclass
+		[self drawRect:drawContext->dirtyRect];
+	}
+	TUIGraphicsPopDrawContext();
+}
+
+/*
+ Tiled drawing. Tiles are sublayers of _tileLayer, which sits below the
+ layers of our subviews. Only tiles that are visible get created and drawn;
+ a few that scrolled out of view are kept for when they come back, and the
+ rest are dropped least recently visible first.
+ */
+
+- (CGRect)_visibleRect
+{
+	if (!self.nsView || self.hidden)
+		return CGRectNull;
+
+	CGRect r = self.bounds;
+	TUIView *v = self;
+	while (v.superview != nil) {
+		TUIView *superview = v.superview;
+		r = [v convertRect:r toView:superview];
+		if (superview.layer.masksToBounds || [superview.layer isKindOfClass:[CAScrollLayer class]])
+			r = CGRectIntersection(r, superview.bounds);
+		if (CGRectIsEmpty(r))
+			return CGRectNull;
+		v = superview;
+	}
+	r = CGRectIntersection(r, v.bounds);
+	if (CGRectIsEmpty(r))
+		return CGRectNull;
+
+	return [self convertRect:r fromView:v];
+}
+
+- (CGRect)_rectForTileWithKey:(NSValue *)key
+{
+	NSPoint p = [key pointValue];
+	CGRect b = self.bounds;
+	CGSize t = self.tileSize;
+	return CGRectIntersection(CGRectMake(b.origin.x + p.x * t.width, b.origin.y + p.y * t.height, t.width, t.height), b);
+}
+
+- (void)_removeTileWithKey:(NSValue *)key
+{
+	[[_tiles objectForKey:key] removeFromSuperlayer];
+	[_tiles removeObjectForKey:key];
+	[_tileUsage removeObject:key];
+}
+
+- (void)_removeAllTiles
+{
+	[[_tiles allValues] makeObjectsPerformSelector:@selector(removeFromSuperlayer)];
+	[_tiles removeAllObjects];
+	[_tileUsage removeAllObjects];
+}
+
+// Draws rect into a standalone bitmap from the backing store pool, which the
+// returned image shares. Doesn't touch the view's own backing store, so it's
+// safe to call from a background queue.
+- (CGImageRef)_createImageOfRect:(CGRect)rect scale:(CGFloat)scale opaque:(BOOL)opaque
+{
+	CFMutableDataRef data = NULL;
+	CGSize size = CGSizeMake(ceil(rect.size.width * scale), ceil(rect.size.height * scale));
+	if (size.width < 1) size.width = 1;
+	if (size.height < 1) size.height = 1;
+	CGContextRef context = TUICreateGraphicsContextWithData(size, opaque, &data);
+	if (!context)
+		return NULL;
+
+	TUIDrawContext drawContext = {
+		.context = context,
+		.scale = scale,
+		.dirtyRect = rect,
+	};
+	CGContextScaleCTM(context, scale, scale);
+	CGContextTranslateCTM(context, -rect.origin.x, -rect.origin.y);
+	CGContextClipToRect(context, rect);
+	[self _drawInDrawContext:&drawContext];
+
+	// the buffer stays alive as long as the image does
+	CGImageRef image = TUICreateCGImageWithBitmapContextData(context, data);
+	CGContextRelease(context);
+	TUIRecycleGraphicsContextData(data);
+	CFRelease(data);
+	return image;
+}
+
+- (TUIViewRenderCacheKey *)_currentRenderCacheKey
+{
+	TUIViewRenderCacheKey *cacheKey = [[TUIViewRenderCacheKey alloc] init];
+	cacheKey.key = _renderCacheKey;
+	cacheKey.size = self.bounds.size;
+	cacheKey.scale = [self.layer respondsToSelector:@selector(contentsScale)] ? self.layer.contentsScale : 1.0f;
+	cacheKey.opaque = self.opaque;
+	return cacheKey;
+}
+
+// The cached bitmap is shared between views, so it's drawn on its own rather
+// than into our (reused) backing store, which isn't needed at all then.
+- (void)_displayFromRenderCache
+{
+	TUIViewRenderCacheKey *cacheKey = [self _currentRenderCacheKey];
+	CGImageRef image = TUIViewRenderCacheGetImage(cacheKey);
+	if (image) {
+		self.layer.contents = (__bridge id)image;
+	} else {
+		image = [self _createImageOfRect:self.bounds scale:cacheKey.scale opaque:cacheKey.opaque];
+		if (!image)
+			return;
+		TUIViewRenderCacheSetImage(cacheKey, image);
+		self.layer.contents = (__bridge id)image;
+		CGImageRelease(image);
+	}
+
+	_context.dirtyRect = CGRectZero;
+	[self _releaseBackingStore];
+}
+
+- (void)_scheduleBackgroundDisplay
+{
+	if (_viewFlags.delegateWillDisplayLayer) {
+		[_viewDelegate viewWillDisplayLayer:self];
+	}
+
+	TUIViewRenderCacheKey *cacheKey = nil;
+	if (_renderCacheKey != nil) {
+		cacheKey = [self _currentRenderCacheKey];
+		CGImageRef image = TUIViewRenderCacheGetImage(cacheKey);
+		if (image) {
+			OSAtomicIncrement32Barrier(&_context.generation);
+			[_drawOperation cancel];
+			_drawOperation = nil;
+			self.layer.contents = (__bridge id)image;
+			_context.dirtyRect = CGRectZero;
+			return;
+		}
+	}
+
+	// whatever is still queued or drawing for this view is out of date now
+	int32_t generation = OSAtomicIncrement32Barrier(&_context.generation);
+	[_drawOperation cancel];
+
+	CGRect b = self.bounds;
+	CGFloat scale = [self.layer respondsToSelector:@selector(contentsScale)] ? self.layer.contentsScale : 1.0f;
+	BOOL opaque = self.opaque;
+	CALayer *layer = self.layer;
+	layer.contents = nil;
+	_context.dirtyRect = CGRectZero;
+
+	// The operation holds on to us until it's done, and we hold on to it while
+	// it's the latest, so let go of it as soon as it's done.
+	NSBlockOperation *operation = [NSBlockOperation blockOperationWithBlock:^{
+		if (generation != _context.generation)
+			return; // a newer draw owns _drawOperation
+
+		CGImageRef image = [self _createImageOfRect:b scale:scale opaque:opaque];
+		if (!image) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				if (generation == _context.generation)
+					_drawOperation = nil;
+			});
+			return;
+		}
+
+		TUIViewPublishDrawResult(^{
+			if (cacheKey)
+				TUIViewRenderCacheSetImage(cacheKey, image);
+			if (generation == _context.generation) {
+				layer.contents = (__bridge id)image;
+				_drawOperation = nil;
+			}
+			CGImageRelease(image);
+		});
+	}];
+	operation.queuePriority = CGRectIsEmpty([self _visibleRect]) ? NSOperationQueuePriorityLow : NSOperationQueuePriorityHigh;
+	_drawOperation = operation;
+	[(self.drawQueue ?: TUIViewSharedDrawQueue()) addOperation:operation];
+}
+
+static NSString * const TUIViewTileGenerationKey = @"TUIViewTileGeneration";
+
+- (void)_drawTile:(CALayer *)tile inRect:(CGRect)tileRect
+{
+	CGFloat scale = 1.0f;
+	if ([tile respondsToSelector:@selector(setContentsScale:)]) {
+		scale = self.layer.contentsScale;
+		tile.contentsScale = scale;
+	}
+	BOOL opaque = self.opaque;
+
+	// every draw supersedes the ones before it, which may still finish later
+	NSInteger generation = [[tile valueForKey:TUIViewTileGenerationKey] integerValue] + 1;
+	[tile setValue:@(generation) forKey:TUIViewTileGenerationKey];
+
+	void (^publishBlock)(CGImageRef) = ^(CGImageRef image) {
+		if ([[tile valueForKey:TUIViewTileGenerationKey] integerValue] != generation) {
+			CGImageRelease(image);
+			return;
+		}
+		[CATransaction begin];
+		[CATransaction setDisableActions:YES];
+		tile.contents = (__bridge id)image;
+		[CATransaction commit];
+		CGImageRelease(image);
+	};
+
+	if (self.drawInBackground) {
+		// tiles are only drawn when they're visible
+		NSBlockOperation *operation = [NSBlockOperation blockOperationWithBlock:^{
+			if ([[tile valueForKey:TUIViewTileGenerationKey] integerValue] != generation)
+				return;
+
+			CGImageRef image = [self _createImageOfRect:tileRect scale:scale opaque:opaque];
+			if (image) {
+				TUIViewPublishDrawResult(^{
+					publishBlock(image);
+				});
+			}
+		}];
+		operation.queuePriority = NSOperationQueuePriorityHigh;
+		[(self.drawQueue ?: TUIViewSharedDrawQueue()) addOperation:operation];
+	} else {
+		CGImageRef image = [self _createImageOfRect:tileRect scale:scale opaque:opaque];
+		if (image)
+			publishBlock(image);
+	}
+}
+
+- (void)_updateVisibleTiles
+{
+	if (!_viewFlags.drawsInTiles)
+		return;
+
+	CGRect b = self.bounds;
+	CGSize t = self.tileSize;
+
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+
+	if (!_tileLayer) {
+		_tileLayer = [CALayer layer];
+		[self.layer insertSublayer:_tileLayer atIndex:0];
+	}
+	if (!CGRectEqualToRect(_tileLayer.bounds, b)) {
+		// tiles along the edges change size, start over
+		[self _removeAllTiles];
+		_tileLayer.bounds = b;
+		_tileLayer.position = CGPointMake(CGRectGetMidX(b), CGRectGetMidY(b));
+	}
+
+	NSUInteger visibleCount = 0;
+	CGRect visible = [self _visibleRect];
+	if (!CGRectIsEmpty(visible)) {
+		NSInteger minColumn = floor((CGRectGetMinX(visible) - b.origin.x) / t.width);
+		NSInteger maxColumn = ceil((CGRectGetMaxX(visible) - b.origin.x) / t.width);
+		NSInteger minRow = floor((CGRectGetMinY(visible) - b.origin.y) / t.height);
+		NSInteger maxRow = ceil((CGRectGetMaxY(visible) - b.origin.y) / t.height);
+
+		for (NSInteger row = minRow; row < maxRow; ++row) {
+			for (NSInteger column = minColumn; column < maxColumn; ++column) {
+				NSValue *key = [NSValue valueWithPoint:NSMakePoint(column, row)];
+				CALayer *tile = [_tiles objectForKey:key];
+				if (!tile) {
+					CGRect tileRect = [self _rectForTileWithKey:key];
+					tile = [CALayer layer];
+					tile.frame = tileRect;
+					tile.opaque = self.opaque;
+					[_tileLayer addSublayer:tile];
+					[_tiles setObject:tile forKey:key];
+					[self _drawTile:tile inRect:tileRect];
+				}
+				[_tileUsage removeObject:key];
+				[_tileUsage addObject:key];
+				visibleCount++;
+			}
+		}
+	}
+
+	while (_tileUsage.count > visibleCount + TUIViewMaximumOffscreenTiles) {
+		[self _removeTileWithKey:[_tileUsage objectAtIndex:0]];
+	}
+
+	[CATransaction commit];
+}
+
+- (void)_displayTiles
+{
+	if (_viewFlags.delegateWillDisplayLayer) {
+		[_viewDelegate viewWillDisplayLayer:self];
+	}
+
+	CGRect dirtyRect = _context.dirtyRect;
+	_context.dirtyRect = CGRectZero;
+	BOOL everything = CGRectEqualToRect(dirtyRect, CGRectZero);
+
+	// dirty tiles are drawn again if they're visible, dropped if they're not
+	CGRect visible = [self _visibleRect];
+	for (NSValue *key in [_tiles allKeys]) {
+		CGRect tileRect = [self _rectForTileWithKey:key];
+		if (!everything && !CGRectIntersectsRect(tileRect, dirtyRect))
+			continue;
+
+		if (CGRectIntersectsRect(tileRect, visible)) {
+			[self _drawTile:[_tiles objectForKey:key] inRect:tileRect];
+		} else {
+			[self _removeTileWithKey:key];
+		}
+	}
+
+	[self _updateVisibleTiles];
+}
+
 - (void)_blockLayout
 {
 	for(TUIView *v in self.subviews) {
@@ -436,6 +1092,7 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 {
 	[self layoutSubviews];
 	[self _blockLayout];
+	[self _updateVisibleTiles];
 	[self.subviews makeObjectsPerformSelector:@selector(ancestorDidLayout)];
 }
 
@@ -446,6 +1103,12 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 
 - (void)setDrawInBackground:(BOOL)drawInBackground
 {
+	if(!drawInBackground && _viewFlags.drawInBackground) {
+		// don't let a pending background draw replace what's drawn from now on
+		OSAtomicIncrement32Barrier(&_context.generation);
+		[_drawOperation cancel];
+		_drawOperation = nil;
+	}
 	_viewFlags.drawInBackground = drawInBackground;
 }
 
@@ -557,13 +1220,44 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 			scale = [[self nsWindow] backingScaleFactor];
 		}
 		
-		if([self.layer respondsToSelector:@selector(setContentsScale:)]) {
-			self.layer.contentsScale = scale;
+		if(![self.layer respondsToSelector:@selector(setContentsScale:)] || fabs(self.layer.contentsScale - scale) < 0.1f)
+			return;
+		
+		// The layer stretches the old contents to its bounds, so they stand in
+		// until we redraw. Visible views redraw right away; offscreen ones wait
+		// until they're scrolled or moved into view.
+		self.layer.contentsScale = scale;
+		if(![self _hasDrawRect])
+			return;
+		
+		if(!CGRectIsEmpty([self _visibleRect]) || ![_layer.contentsGravity isEqualToString:kCAGravityResize]) {
+			// other gravities would show the old contents at the wrong size
 			[self setNeedsDisplay];
+		} else if(!_viewFlags.needsDisplayAtNewScale) {
+			_viewFlags.needsDisplayAtNewScale = 1;
+			TUIViewPendingRescaleCount++;
 		}
 	}
 }
 
+- (void)_displayIfNeededAtNewScale
+{
+	if(_viewFlags.needsDisplayAtNewScale && !CGRectIsEmpty([self _visibleRect]))
+		[self setNeedsDisplay];
+}
+
+- (void)_stopWaitingToDisplayAtNewScale
+{
+	if(_viewFlags.needsDisplayAtNewScale) {
+		// hidden or out of the window, so it's not worth a scroll update;
+		// redraw whenever it's shown again
+		_viewFlags.needsDisplayAtNewScale = 0;
+		TUIViewPendingRescaleCount--;
+		[self setNeedsDisplay];
+	}
+	[self.subviews makeObjectsPerformSelector:_cmd];
+}
+
 - (void)prepareSubview:(TUIView *)view insertionBlock:(void (^)(void))block
 {
 	if (!_subviews) {
@@ -602,6 +1296,8 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 - (void)setFrame:(CGRect)f
 {
 	self.layer.frame = f;
+	[self.superview _subviewGeometryDidChange];
+	[self _displayIfNeededAtNewScale];
 	[self.subviews makeObjectsPerformSelector:@selector(ancestorDidLayout)];
     [[NSNotificationCenter defaultCenter] postNotificationName:TUIViewFrameDidChangeNotification object:self];
 }
@@ -615,6 +1311,7 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 {
 	self.layer.bounds = b;
 	[self.subviews makeObjectsPerformSelector:@selector(ancestorDidLayout)];
+	[self.superview _subviewGeometryDidChange];
 }
 
 - (void)setCenter:(CGPoint)c
@@ -640,6 +1337,7 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 - (void)setTransform:(CGAffineTransform)t
 {
 	[self.layer setAffineTransform:t];
+	[self.superview _subviewGeometryDidChange];
 }
 
 - (NSArray *)sortedSubviews // back to front order
@@ -769,6 +1467,7 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 		[self didMoveToSuperview];
 		[self didMoveFromTUINSView:nsView];
 		[self viewHierarchyDidChange];
+		[superview _subviewGeometryDidChange];
 	}
 }
 
@@ -841,7 +1540,7 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 {
 	[self prepareSubview:view insertionBlock:^{
 		[self.subviews insertObject:view atIndex:index];
-		[self.layer insertSublayer:view.layer atIndex:(unsigned)index];
+		[self.layer insertSublayer:view.layer atIndex:(unsigned)index + (_tileLayer != nil ? 1 : 0)];
 	}];
 }
 
@@ -1025,6 +1724,17 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 	[self setNeedsDisplay];
 }
 
+- (TUIViewDrawInContext)drawInContext
+{
+	return drawInContext;
+}
+
+- (void)setDrawInContext:(TUIViewDrawInContext)d
+{
+	drawInContext = [d copy];
+	[self setNeedsDisplay];
+}
+
 - (void)setEverythingNeedsDisplay
 {
 	[self setNeedsDisplay];
@@ -1033,12 +1743,25 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 
 - (void)setNeedsDisplay
 {
+	_otherKeyednessContents = nil;
+	_context.dirtyRect = CGRectZero;
 	[self.layer setNeedsDisplay];
 }
 
 - (void)setNeedsDisplayInRect:(CGRect)rect
 {
-	_context.dirtyRect = rect;
+	rect = CGRectIntersection(rect, self.bounds);
+	if(CGRectIsEmpty(rect))
+		return;
+	
+	_otherKeyednessContents = nil;
+	
+	if(![self.layer needsDisplay]) {
+		_context.dirtyRect = rect;
+	} else if(!CGRectEqualToRect(_context.dirtyRect, CGRectZero)) {
+		// add to the pending region, a pending full redraw stays full
+		_context.dirtyRect = CGRectUnion(_context.dirtyRect, rect);
+	}
 	[self.layer setNeedsDisplayInRect:rect];
 }
 
@@ -1060,6 +1783,7 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 - (void)setAlpha:(CGFloat)a
 {
 	self.layer.opacity = a;
+	[self.superview _subviewGeometryDidChange];
 }
 
 - (BOOL)isOpaque
@@ -1070,6 +1794,7 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 - (void)setOpaque:(BOOL)o
 {
 	self.layer.opaque = o;
+	[self.superview _subviewGeometryDidChange];
 }
 
 - (BOOL)isHidden
@@ -1080,6 +1805,11 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 - (void)setHidden:(BOOL)h
 {
 	self.layer.hidden = h;
+	[self.superview _subviewGeometryDidChange];
+	if(h)
+		[self _stopWaitingToDisplayAtNewScale];
+	else
+		[self _displayIfNeededAtNewScale];
 	[self.subviews makeObjectsPerformSelector:@selector(ancestorDidLayout)];
 }
 
@@ -1107,6 +1837,178 @@ static void TUISetCurrentContextScaleFactor(CGFloat s)
 	_viewFlags.clearsContextBeforeDrawing = newValue;
 }
 
+- (BOOL)drawsInTiles
+{
+	return _viewFlags.drawsInTiles;
+}
+
+- (void)setDrawsInTiles:(BOOL)drawsInTiles
+{
+	if(drawsInTiles == _viewFlags.drawsInTiles)
+		return;
+	
+	_viewFlags.drawsInTiles = drawsInTiles;
+	if(drawsInTiles) {
+		TUIViewTiledViewCount++;
+		_tiles = [[NSMutableDictionary alloc] init];
+		_tileUsage = [[NSMutableArray alloc] init];
+		[self _releaseBackingStore];
+		self.layer.contents = nil;
+	} else {
+		TUIViewTiledViewCount--;
+		[self _removeAllTiles];
+		[_tileLayer removeFromSuperlayer];
+		_tileLayer = nil;
+		_tiles = nil;
+		_tileUsage = nil;
+	}
+	[self setNeedsDisplay];
+}
+
+- (id<NSObject, NSCopying>)renderCacheKey
+{
+	return _renderCacheKey;
+}
+
+- (void)setRenderCacheKey:(id<NSObject, NSCopying>)key
+{
+	if(key == _renderCacheKey || [key isEqual:_renderCacheKey])
+		return;
+	_renderCacheKey = [key copyWithZone:NULL];
+	[self setNeedsDisplay];
+}
+
++ (void)setRenderCacheByteLimit:(NSUInteger)limit
+{
+	TUIViewRenderCacheByteLimit = limit;
+	TUIViewTrimRenderCache(limit);
+}
+
++ (NSUInteger)renderCacheHitCount
+{
+	return TUIViewRenderCacheHits;
+}
+
++ (NSUInteger)renderCacheMissCount
+{
+	return TUIViewRenderCacheMisses;
+}
+
++ (void)setSkipsDrawingOccludedViews:(BOOL)skips
+{
+	TUIViewSkipsDrawingOccludedViews = skips;
+}
+
++ (BOOL)skipsDrawingOccludedViews
+{
+	return TUIViewSkipsDrawingOccludedViews;
+}
+
+// back to front, each view that draws something along with the part of it that isn't clipped, in root's coordinates
+- (void)_collectDrawingViews:(NSMutableArray *)views rects:(NSMutableArray *)rects clip:(CGRect)clip root:(TUIView *)root
+{
+	if(self.hidden || self.alpha <= 0.0)
+		return;
+	
+	CGRect r = CGRectIntersection([self convertRect:self.bounds toView:root], clip);
+	if(CGRectIsEmpty(r))
+		return;
+	
+	CGColorRef backgroundColor = self.layer.backgroundColor;
+	if([self _hasDrawRect] || (backgroundColor && CGColorGetAlpha(backgroundColor) > 0.0)) {
+		[views addObject:self];
+		[rects addObject:[NSValue valueWithRect:r]];
+	}
+	
+	if(self.layer.masksToBounds || [self.layer isKindOfClass:[CAScrollLayer class]])
+		clip = r;
+	for(TUIView *subview in self.sortedSubviews) {
+		[subview _collectDrawingViews:views rects:rects clip:clip root:root];
+	}
+}
+
+- (NSDictionary *)overdrawReport
+{
+	CGRect region = self.nsView ? [self _visibleRect] : self.bounds;
+	region = CGRectIntegral(region);
+	NSInteger width = CGRectIsEmpty(region) ? 0 : (NSInteger)region.size.width;
+	NSInteger height = CGRectIsEmpty(region) ? 0 : (NSInteger)region.size.height;
+	
+	NSMutableArray *views = [NSMutableArray array];
+	NSMutableArray *rects = [NSMutableArray array];
+	if(width > 0 && height > 0)
+		[self _collectDrawingViews:views rects:rects clip:region root:self];
+	
+	// one count per point, and whether something opaque has been drawn over it yet
+	uint8_t *counts = calloc(MAX(width * height, 1), 1);
+	uint8_t *covered = calloc(MAX(width * height, 1), 1);
+	NSMutableArray *shouldBeOpaque = [NSMutableArray array];
+	NSMutableArray *occluded = [NSMutableArray array];
+	
+	// front to back, so it's known what's already covered when a view is reached
+	for(NSInteger i = (NSInteger)views.count - 1; i >= 0; --i) {
+		TUIView *v = [views objectAtIndex:i];
+		CGRect r = CGRectIntegral([[rects objectAtIndex:i] rectValue]);
+		NSInteger minX = MAX(0, (NSInteger)(CGRectGetMinX(r) - region.origin.x));
+		NSInteger maxX = MIN(width, (NSInteger)(CGRectGetMaxX(r) - region.origin.x));
+		NSInteger minY = MAX(0, (NSInteger)(CGRectGetMinY(r) - region.origin.y));
+		NSInteger maxY = MIN(height, (NSInteger)(CGRectGetMaxY(r) - region.origin.y));
+		
+		BOOL coversOthers = v.opaque && v.alpha >= 1.0 && CATransform3DIsIdentity(v.layer.transform);
+		BOOL seen = NO;
+		for(NSInteger y = minY; y < maxY; ++y) {
+			for(NSInteger x = minX; x < maxX; ++x) {
+				NSInteger index = y * width + x;
+				if(!covered[index])
+					seen = YES;
+				if(counts[index] < UINT8_MAX)
+					counts[index]++;
+				if(coversOthers)
+					covered[index] = 1;
+			}
+		}
+		
+		if(!seen)
+			[occluded addObject:v];
+		
+		CGColorRef backgroundColor = v.layer.backgroundColor;
+		if(!v.opaque && backgroundColor && CGColorGetAlpha(backgroundColor) >= 1.0)
+			[shouldBeOpaque addObject:v];
+	}
+	
+	NSUInteger total = 0;
+	NSUInteger maximum = 0;
+	for(NSInteger i = 0; i < width * height; ++i) {
+		total += counts[i];
+		maximum = MAX(maximum, counts[i]);
+	}
+	free(counts);
+	free(covered);
+	
+	return @{
+		TUIViewOverdrawAverageKey: @(width * height > 0 ? (double)total / (width * height) : 0.0),
+		TUIViewOverdrawMaximumKey: @(maximum),
+		TUIViewOverdrawShouldBeOpaqueKey: shouldBeOpaque,
+		TUIViewOverdrawOccludedKey: occluded,
+	};
+}
+
+- (CGSize)tileSize
+{
+	if(_tileSize.width <= 0.0 || _tileSize.height <= 0.0)
+		return CGSizeMake(TUIViewDefaultTileSize, TUIViewDefaultTileSize);
+	return _tileSize;
+}
+
+- (void)setTileSize:(CGSize)tileSize
+{
+	_tileSize = tileSize;
+	if(_viewFlags.drawsInTiles) {
+		[self _removeAllTiles];
+		[self setNeedsDisplay];
+	}
+}
+
 @end
 
 @implementation TUIView (TUIViewAppKit)